@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class Graph_Arena
+ * @brief Bump allocator over caller-supplied storage, used for the scratch memory of the renders.
+ *
+ * Allocations are released in bulk by going back to a mark, nothing is ever taken from the heap.
+ * When the storage is exhausted alloc returns NULL and the caller falls back to a path that needs
+ * no memory.
+ */
+class Graph_Arena
+{
+private:
+    uint8_t *buffer; ///< Storage of the arena.
+    size_t size;     ///< Size of the storage in bytes.
+    size_t used;     ///< Bytes in use, including alignment padding.
+    size_t peak;     ///< Highest number of bytes ever in use.
+
+public:
+    /**
+     * @brief Constructor for the Graph_Arena class.
+     * @param buffer Storage of the arena (NULL for an empty arena).
+     * @param size Size of the storage in bytes.
+     */
+    Graph_Arena(void *buffer = NULL, size_t size = 0) : buffer((uint8_t *)buffer), size(buffer ? size : 0), used(0), peak(0) {}
+
+    /**
+     * @brief Allocate an aligned block.
+     * @param bytes Size of the block.
+     * @param align Alignment of the block, a power of 2.
+     * @return The block, NULL if the arena is exhausted.
+     */
+    void *alloc(size_t bytes, size_t align)
+    {
+        uintptr_t base = (uintptr_t)buffer;
+        size_t start = ((base + used + align - 1) & ~(uintptr_t)(align - 1)) - base;
+        if (start > size || bytes > size - start)
+            return NULL;
+
+        used = start + bytes;
+        peak = (used > peak) ? used : peak;
+        return buffer + start;
+    }
+
+    /**
+     * @brief Allocate an array.
+     * @param n Number of elements.
+     * @return The array, NULL if the arena is exhausted.
+     */
+    template <typename T>
+    T *alloc(size_t n)
+    {
+        if (n > size / sizeof(T))
+            return NULL;
+        return (T *)alloc(n * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @brief Get the current position, to release everything allocated after it with release.
+     */
+    size_t mark(void) const { return used; }
+
+    /**
+     * @brief Release every block allocated after a mark.
+     * @param position Value returned by mark.
+     */
+    void release(size_t position) { used = (position < used) ? position : used; }
+
+    size_t getSize(void) const { return size; }
+    size_t getUsed(void) const { return used; }
+    size_t getPeak(void) const { return peak; }
+};
@@ -0,0 +1,136 @@
+#include "Graph_Dashboard.h"
+
+Graph_Dashboard::Graph_Dashboard(uint32_t budgetUs, uint32_t budgetBytes)
+    : count(0), budgetUs(budgetUs), budgetBytes(budgetBytes)
+{
+}
+
+int8_t Graph_Dashboard::add(Graph_TFT *chart, graph_draw_fn draw, void *context, uint8_t priority, uint32_t interval)
+{
+    if (count >= GRAPH_MAX_CHARTS || chart == NULL)
+        return -1;
+
+    if (draw == NULL)
+    {
+        chart->setRetained(true);
+    }
+
+    Chart &c = charts[count];
+    c.chart = chart;
+    c.draw = draw;
+    c.context = context;
+    c.priority = priority;
+    c.interval = interval;
+    c.dirty = true;
+    c.drawn = false;
+    c.last = 0;
+    c.age = 0;
+    c.stats = GRAPH_CHART_STATS();
+    return count++;
+}
+
+void Graph_Dashboard::invalidate(uint8_t index)
+{
+    if (index >= count)
+        return;
+
+    if (charts[index].dirty)
+    {
+        charts[index].stats.coalesced++;
+    }
+    charts[index].dirty = true;
+}
+
+void Graph_Dashboard::invalidateAll(void)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        invalidate(i);
+    }
+}
+
+void Graph_Dashboard::setBudget(uint32_t us, uint32_t bytes)
+{
+    budgetUs = us;
+    budgetBytes = bytes;
+}
+
+bool Graph_Dashboard::due(const Chart &c, uint32_t now) const
+{
+    bool dirty = c.dirty || (c.draw == NULL && c.chart->isDirty());
+    return dirty && (!c.drawn || now - c.last >= c.interval);
+}
+
+uint8_t Graph_Dashboard::update(uint32_t now)
+{
+    uint32_t spentUs = 0;
+    uint32_t spentBytes = 0;
+    uint8_t drawn = 0;
+    bool tried[GRAPH_MAX_CHARTS] = {false};
+
+    while (true)
+    {
+        // Next chart due by priority, raised by the updates it was left out of
+        int8_t next = -1;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (tried[i] || !due(charts[i], now))
+                continue;
+            if (next < 0 || charts[i].priority + charts[i].age > charts[next].priority + charts[next].age)
+            {
+                next = i;
+            }
+        }
+        if (next < 0)
+            break;
+
+        Chart &c = charts[next];
+        tried[next] = true;
+
+        // A chart that doesn't fit is left for the next update, a cheaper one may still fit. The
+        // cost of a chart never drawn is unknown, it only fits alone
+        bool fits = c.drawn && (budgetUs == 0 || spentUs + c.stats.us <= budgetUs) &&
+                    (budgetBytes == 0 || spentBytes + c.stats.bytes <= budgetBytes);
+        if (drawn > 0 && !fits)
+        {
+            c.age++;
+            c.stats.deferred++;
+            continue;
+        }
+
+        uint32_t bytes = c.chart->getPanelCounters().bytes;
+        uint32_t start = graphMicros();
+        if (c.draw != NULL)
+        {
+            c.draw(*c.chart, c.context);
+        }
+        else
+        {
+            c.chart->render();
+        }
+        c.stats.us = graphMicros() - start;
+        c.stats.bytes = c.chart->getPanelCounters().bytes - bytes;
+        c.stats.draws++;
+        spentUs += c.stats.us;
+        spentBytes += c.stats.bytes;
+
+        c.dirty = false;
+        c.drawn = true;
+        c.last = now;
+        c.age = 0;
+        drawn++;
+    }
+
+    return drawn;
+}
+
+bool Graph_Dashboard::isDirty(uint8_t index) const
+{
+    return index < count && (charts[index].dirty || (charts[index].draw == NULL && charts[index].chart->isDirty()));
+}
+
+const GRAPH_CHART_STATS &Graph_Dashboard::getStats(uint8_t index) const
+{
+    static const GRAPH_CHART_STATS none = GRAPH_CHART_STATS();
+    return (index < count) ? charts[index].stats : none;
+}
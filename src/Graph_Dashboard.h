@@ -0,0 +1,131 @@
+#pragma once
+#include "Graph_TFT.h"
+
+#define GRAPH_MAX_CHARTS 8 ///< Maximum number of charts of a dashboard.
+
+/**
+ * @brief Draws a chart of a dashboard, typically calling one of its setData functions.
+ * @param chart Chart to draw.
+ * @param context Pointer given when the chart was added.
+ */
+typedef void (*graph_draw_fn)(Graph_TFT &chart, void *context);
+
+/**
+ * @struct GRAPH_CHART_STATS
+ * @brief Scheduling statistics of a chart of a dashboard.
+ */
+struct GRAPH_CHART_STATS
+{
+    uint32_t us;        ///< Time taken by the last draw in microseconds.
+    uint32_t bytes;     ///< Bytes sent to the panel by the last draw.
+    uint32_t draws;     ///< Number of draws.
+    uint32_t coalesced; ///< Number of invalidations merged into a pending draw.
+    uint32_t deferred;  ///< Number of updates the chart was due but left out by the budget.
+};
+
+/**
+ * @class Graph_Dashboard
+ * @brief Owns several charts sharing a panel and draws the changed ones under a per-frame budget.
+ *
+ * New data only invalidates a chart; update() then draws the invalidated charts by decreasing
+ * priority, as long as the time and bytes spent in the frame stay within the budget. The cost of a
+ * chart is predicted from its last draw. Invalidations arriving before a chart was drawn are merged
+ * into one draw, and a chart with a minimum interval is not drawn more often than that, so a fast
+ * low priority source costs one draw per interval. Every update left out raises the priority of a
+ * chart by one, so none starves, and the first chart of a frame is drawn whatever its cost.
+ *
+ * A chart added without a draw function is in retained mode: its setters mark it changed
+ * themselves and the dashboard draws it with render().
+ */
+class Graph_Dashboard
+{
+private:
+    /**
+     * @struct Chart
+     * @brief A chart of the dashboard and its scheduling state.
+     */
+    struct Chart
+    {
+        Graph_TFT *chart;        ///< Chart drawn.
+        graph_draw_fn draw;      ///< Function drawing the chart, NULL if retained.
+        void *context;           ///< Pointer passed to draw.
+        uint8_t priority;        ///< Priority, higher first.
+        uint32_t interval;       ///< Minimum time between two draws in microseconds.
+        bool dirty;              ///< Whether the chart has to be drawn.
+        bool drawn;              ///< Whether the chart was ever drawn.
+        uint32_t last;           ///< Time of the last draw.
+        uint16_t age;            ///< Updates since the chart is due, added to its priority.
+        GRAPH_CHART_STATS stats; ///< Scheduling statistics.
+    };
+
+    Chart charts[GRAPH_MAX_CHARTS]; ///< Charts of the dashboard.
+    uint8_t count;                  ///< Number of charts.
+    uint32_t budgetUs;              ///< Time budget of a frame in microseconds, 0 for none.
+    uint32_t budgetBytes;           ///< Byte budget of a frame, 0 for none.
+
+    /**
+     * @brief Check whether a chart has to be drawn by an update.
+     */
+    bool due(const Chart &c, uint32_t now) const;
+
+public:
+    /**
+     * @brief Constructor for the Graph_Dashboard class.
+     * @param budgetUs Time budget of a frame in microseconds, 0 for none.
+     * @param budgetBytes Byte budget of a frame, 0 for none.
+     */
+    Graph_Dashboard(uint32_t budgetUs = 0, uint32_t budgetBytes = 0);
+
+    /**
+     * @brief Add a chart to the dashboard, invalidated.
+     * @param chart Chart, kept by reference.
+     * @param draw Function drawing the chart, NULL to switch the chart to retained mode and draw it with render().
+     * @param context Pointer passed to draw.
+     * @param priority Priority of the chart, higher first (default is 0).
+     * @param interval Minimum time between two draws of the chart in microseconds (default is 0).
+     * @return Index of the chart, -1 if the dashboard is full.
+     */
+    int8_t add(Graph_TFT *chart, graph_draw_fn draw, void *context = NULL, uint8_t priority = 0, uint32_t interval = 0);
+
+    /**
+     * @brief Mark a chart as changed, to be drawn by a next update.
+     * @param index Index of the chart.
+     */
+    void invalidate(uint8_t index);
+
+    /**
+     * @brief Mark every chart as changed.
+     */
+    void invalidateAll(void);
+
+    /**
+     * @brief Set the budget of a frame.
+     * @param us Time budget in microseconds, 0 for none.
+     * @param bytes Byte budget, 0 for none.
+     */
+    void setBudget(uint32_t us, uint32_t bytes);
+
+    /**
+     * @brief Draw the charts due, within the budget.
+     * @param now Current time in microseconds (graphMicros()).
+     * @return Number of charts drawn.
+     */
+    uint8_t update(uint32_t now);
+
+    /**
+     * @brief Check whether a chart is waiting to be drawn.
+     * @param index Index of the chart.
+     */
+    bool isDirty(uint8_t index) const;
+
+    /**
+     * @brief Get the scheduling statistics of a chart.
+     * @param index Index of the chart, zeroed statistics if out of range.
+     */
+    const GRAPH_CHART_STATS &getStats(uint8_t index) const;
+
+    /**
+     * @brief Get the number of charts.
+     */
+    uint8_t getCount(void) const { return count; }
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "Graph_Series.h"
+
+#define GRAPH_HEAT_LEVELS 256 ///< Maximum number of colours of a heatmap palette.
+
+/**
+ * @brief Fill a heatmap palette by blending linearly between evenly spaced RGB565 colours.
+ *
+ * Computed once, the palette turns a level into its colour with a single lookup.
+ * @param lut RGB565 palette to fill.
+ * @param size Number of colours, up to GRAPH_HEAT_LEVELS.
+ * @param stops Colours of the lowest to the highest level (NULL for black, blue, red, yellow, white).
+ * @param n_stops Number of stops, at least 2.
+ */
+inline void graphHeatLUT(uint16_t *lut, uint16_t size, const uint16_t *stops = NULL, uint8_t n_stops = 0)
+{
+    static const uint16_t defaultStops[] = {0x0000, 0x001f, 0xf800, 0xffe0, 0xffff};
+    if (stops == NULL || n_stops < 2)
+    {
+        stops = defaultStops;
+        n_stops = sizeof(defaultStops) / sizeof(defaultStops[0]);
+    }
+
+    for (uint16_t i = 0; i < size; i++)
+    {
+        // Position of the level between two stops, in 1/256
+        uint32_t pos = (size > 1) ? (uint32_t)i * (n_stops - 1) * 256 / (size - 1) : 0;
+        uint8_t s = pos >> 8;
+        uint32_t t = pos & 0xff;
+        if (s >= n_stops - 1)
+        {
+            s = n_stops - 2;
+            t = 256;
+        }
+
+        uint16_t a = stops[s], b = stops[s + 1];
+        uint32_t r = (((a >> 11) & 0x1f) * (256 - t) + ((b >> 11) & 0x1f) * t) >> 8;
+        uint32_t g = (((a >> 5) & 0x3f) * (256 - t) + ((b >> 5) & 0x3f) * t) >> 8;
+        uint32_t bl = ((a & 0x1f) * (256 - t) + (b & 0x1f) * t) >> 8;
+        lut[i] = (r << 11) | (g << 5) | bl;
+    }
+}
+
+/**
+ * @class Graph_Heatmap
+ * @brief History of the columns of a heatmap (spectrogram), over caller-supplied storage.
+ *
+ * Each column holds the palette level of every bin, one byte per bin, so a column is turned into
+ * pixels with one lookup per row. Pushing into a full history overwrites the oldest column.
+ */
+class Graph_Heatmap
+{
+private:
+    uint8_t *levels;    ///< Storage for capacity columns of bins levels.
+    uint16_t capacity;  ///< Maximum number of columns.
+    uint16_t bins;      ///< Number of bins of a column.
+    uint16_t head;      ///< Index of the next column written.
+    uint16_t count;     ///< Number of columns held.
+    const uint16_t *lut; ///< RGB565 colour of every level.
+    uint16_t lutSize;   ///< Number of levels.
+
+public:
+    /**
+     * @brief Constructor for the Graph_Heatmap class.
+     * @param buffer Storage for capacity * bins levels (NULL for an empty heatmap).
+     * @param capacity Number of columns of the history.
+     * @param bins Number of bins of a column.
+     * @param lut RGB565 palette, kept by reference (see graphHeatLUT).
+     * @param lutSize Number of colours of the palette, up to GRAPH_HEAT_LEVELS.
+     */
+    Graph_Heatmap(uint8_t *buffer = NULL, uint16_t capacity = 0, uint16_t bins = 0, const uint16_t *lut = NULL, uint16_t lutSize = 0)
+        : levels(buffer), capacity((buffer && bins && lut && lutSize) ? capacity : 0), bins(bins), head(0), count(0),
+          lut(lut), lutSize((lutSize < GRAPH_HEAT_LEVELS) ? lutSize : GRAPH_HEAT_LEVELS) {}
+
+    /**
+     * @brief Append a column, dropping the oldest one if the history is full.
+     * @param values Value of every bin.
+     * @param min Value of the lowest level.
+     * @param max Value of the highest level.
+     */
+    template <typename T>
+    void push(const T *values, T min, T max)
+    {
+        if (capacity == 0)
+            return;
+
+        uint8_t *column = levels + (size_t)head * bins;
+        for (uint16_t b = 0; b < bins; b++)
+        {
+            column[b] = Graph_Scale<T>::map(values[b], min, max, lutSize - 1);
+        }
+        head = (head + 1 == capacity) ? 0 : head + 1;
+        if (count < capacity)
+            count++;
+    }
+
+    /**
+     * @brief Get the levels of a column.
+     * @param i Index of the column, 0 being the oldest one.
+     */
+    const uint8_t *column(uint16_t i) const
+    {
+        uint32_t idx = (uint32_t)head + capacity - count + i;
+        return levels + (size_t)((idx >= capacity) ? idx - capacity : idx) * bins;
+    }
+
+    /**
+     * @brief Get the level shown by a row of a column, the first bin at the bottom.
+     *
+     * With more bins than rows, a row shows the highest level of its bins, peaks are never lost.
+     * @param i Index of the column, 0 being the oldest one.
+     * @param r Row, 0 at the top.
+     * @param rows Number of rows.
+     */
+    uint8_t level(uint16_t i, uint16_t r, uint16_t rows) const
+    {
+        const uint8_t *c = column(i);
+        uint32_t from = (uint32_t)(rows - 1 - r) * bins / rows;
+        uint32_t to = (uint32_t)(rows - r) * bins / rows;
+        uint8_t highest = c[from];
+        for (uint32_t b = from + 1; b < to; b++)
+        {
+            highest = (c[b] > highest) ? c[b] : highest;
+        }
+        return highest;
+    }
+
+    /**
+     * @brief Turn a column into a vertical run of pixels, from top to bottom.
+     * @param i Index of the column, 0 being the oldest one.
+     * @param pixels RGB565 pixels of the column.
+     * @param rows Number of rows.
+     */
+    void render(uint16_t i, uint16_t *pixels, uint16_t rows) const
+    {
+        for (uint16_t r = 0; r < rows; r++)
+        {
+            pixels[r] = lut[level(i, r, rows)];
+        }
+    }
+
+    /**
+     * @brief Get the colour of a level.
+     */
+    uint16_t color(uint8_t level) const { return lut[level]; }
+
+    /**
+     * @brief Remove every column.
+     */
+    void clear(void)
+    {
+        head = 0;
+        count = 0;
+    }
+
+    uint16_t size(void) const { return count; }
+    uint16_t getCapacity(void) const { return capacity; }
+    uint16_t getBins(void) const { return bins; }
+};
@@ -0,0 +1,191 @@
+#include "Graph_Ingest.h"
+
+uint16_t graphCRC16(uint16_t crc, uint8_t byte)
+{
+    static const uint16_t table[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+                                       0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef};
+    crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (byte >> 4)];
+    crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (byte & 0x0f)];
+    return crc;
+}
+
+Graph_Ingest::Graph_Ingest(uint8_t *buffer, uint32_t capacity)
+    : buffer(buffer), capacity(buffer ? capacity : 0), head(0), count(0), sequence(0), synced(false), markedTime(0),
+      byteRate(0), frameRate(0)
+{
+    for (uint8_t c = 0; c < GRAPH_INGEST_CHANNELS; c++)
+    {
+        series[c] = NULL;
+        lengths[c] = 0;
+    }
+    resetCounters();
+}
+
+void Graph_Ingest::bind(uint8_t channel, uint16_t *data, uint16_t n)
+{
+    if (channel >= GRAPH_INGEST_CHANNELS)
+        return;
+    series[channel] = data;
+    lengths[channel] = data ? n : 0;
+}
+
+void Graph_Ingest::bind(uint16_t *const *data, uint8_t channels, uint16_t n)
+{
+    for (uint8_t c = 0; c < channels; c++)
+        bind(c, data[c], n);
+}
+
+uint8_t *Graph_Ingest::receiveBuffer(uint32_t &room)
+{
+    uint32_t tail = head + count;
+    tail = (tail >= capacity) ? tail - capacity : tail;
+    uint32_t end = (tail >= head && count < capacity) ? capacity : head;
+    room = (count < capacity) ? end - tail : 0;
+    return buffer + tail;
+}
+
+uint32_t Graph_Ingest::feed(const uint8_t *data, uint32_t n)
+{
+    uint32_t kept = 0;
+    while (kept < n)
+    {
+        uint32_t room;
+        uint8_t *p = receiveBuffer(room);
+        if (room == 0)
+            break;
+        room = (room < n - kept) ? room : n - kept;
+        for (uint32_t i = 0; i < room; i++)
+            p[i] = data[kept + i];
+        received(room);
+        kept += room;
+    }
+    counters.overrun += n - kept;
+    return kept;
+}
+
+uint32_t Graph_Ingest::decode(void)
+{
+    uint32_t decoded = 0;
+    while (count >= GRAPH_INGEST_HEADER)
+    {
+        if (at(0) != GRAPH_INGEST_SYNC0 || at(1) != GRAPH_INGEST_SYNC1)
+        {
+            consume(1);
+            counters.skipped++;
+            continue;
+        }
+
+        uint32_t length = at16(2);
+        if (length < GRAPH_INGEST_HEADER - 4 || length + 6 > capacity)
+        {
+            // Impossible length, a sync pattern inside the data or a corrupted header
+            consume(1);
+            counters.rejected++;
+            continue;
+        }
+        if (count < length + 6)
+            break;
+
+        uint16_t crc = 0xffff;
+        for (uint32_t i = 2; i < length + 4; i++)
+            crc = graphCRC16(crc, at(i));
+        if (crc != at16(length + 4))
+        {
+            // Only the sync is skipped, a frame may start inside the rejected one
+            consume(1);
+            counters.rejected++;
+            continue;
+        }
+
+        uint8_t channels = at(4);
+        uint8_t seq = at(5);
+        uint32_t offset = at16(6);
+        uint32_t bytes = length - (GRAPH_INGEST_HEADER - 4);
+        uint32_t n = (channels > 0) ? bytes / (2 * channels) : 0;
+        bool valid = channels > 0 && channels <= GRAPH_INGEST_CHANNELS && bytes == n * 2 * channels;
+        for (uint8_t c = 0; valid && c < channels; c++)
+            valid = series[c] == NULL || offset + n <= lengths[c];
+        if (!valid)
+        {
+            consume(length + 6);
+            counters.rejected++;
+            continue;
+        }
+
+        // A sequence number going back (sender restarted, frame repeated) is followed as is
+        uint8_t gap = seq - sequence;
+        counters.dropped += (synced && gap < 128) ? gap : 0;
+        sequence = seq + 1;
+        synced = true;
+
+        uint32_t p = GRAPH_INGEST_HEADER;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            for (uint8_t c = 0; c < channels; c++, p += 2)
+            {
+                if (series[c] != NULL)
+                {
+                    series[c][offset + k] = at16(p);
+                    counters.samples++;
+                }
+            }
+        }
+        consume(length + 6);
+        counters.frames++;
+        decoded++;
+    }
+    return decoded;
+}
+
+uint32_t Graph_Ingest::encode(uint8_t *out, uint32_t room, const uint16_t *const *data, uint8_t channels, uint16_t n,
+                              uint16_t offset, uint8_t seq)
+{
+    uint32_t size = GRAPH_INGEST_BYTES((uint32_t)channels, n);
+    if (channels == 0 || channels > GRAPH_INGEST_CHANNELS || size > room || size - 6 > 0xffff)
+        return 0;
+
+    uint32_t length = size - 6;
+    out[0] = GRAPH_INGEST_SYNC0;
+    out[1] = GRAPH_INGEST_SYNC1;
+    out[2] = length & 0xff;
+    out[3] = length >> 8;
+    out[4] = channels;
+    out[5] = seq;
+    out[6] = offset & 0xff;
+    out[7] = offset >> 8;
+    uint32_t p = GRAPH_INGEST_HEADER;
+    for (uint16_t k = 0; k < n; k++)
+    {
+        for (uint8_t c = 0; c < channels; c++)
+        {
+            out[p++] = data[c][k] & 0xff;
+            out[p++] = data[c][k] >> 8;
+        }
+    }
+    uint16_t crc = 0xffff;
+    for (uint32_t i = 2; i < p; i++)
+        crc = graphCRC16(crc, out[i]);
+    out[p++] = crc & 0xff;
+    out[p++] = crc >> 8;
+    return p;
+}
+
+void Graph_Ingest::measure(uint32_t now)
+{
+    uint32_t elapsed = now - markedTime;
+    if (elapsed > 0)
+    {
+        byteRate = (uint32_t)((uint64_t)(counters.bytes - marked.bytes) * 1000000 / elapsed);
+        frameRate = (uint32_t)((uint64_t)(counters.frames - marked.frames) * 1000000 / elapsed);
+    }
+    marked = counters;
+    markedTime = now;
+}
+
+void Graph_Ingest::resetCounters(void)
+{
+    counters = GRAPH_INGEST_COUNTERS();
+    marked = counters;
+    byteRate = 0;
+    frameRate = 0;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define GRAPH_INGEST_SYNC0 0xA5    ///< First byte of every frame.
+#define GRAPH_INGEST_SYNC1 0x5A    ///< Second byte of every frame.
+#define GRAPH_INGEST_CHANNELS 8    ///< Maximum number of channels of a frame.
+#define GRAPH_INGEST_HEADER 8      ///< Sync (2) + length (2) + channels (1) + sequence (1) + offset (2) bytes.
+#define GRAPH_INGEST_OVERHEAD 10   ///< Header + CRC (2) bytes of every frame.
+#define GRAPH_INGEST_BYTES(channels, n) (GRAPH_INGEST_OVERHEAD + 2 * (channels) * (n)) ///< Bytes of a frame of n samples per channel.
+
+/**
+ * @brief Update a CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) with one byte.
+ *
+ * Computed a nibble at a time from a 16 entries table, 32 bytes of flash.
+ */
+uint16_t graphCRC16(uint16_t crc, uint8_t byte);
+
+/**
+ * @struct GRAPH_INGEST_COUNTERS
+ * @brief Counters of a Graph_Ingest since it was created or reset.
+ */
+struct GRAPH_INGEST_COUNTERS
+{
+    uint32_t bytes;   ///< Bytes received.
+    uint32_t frames;  ///< Frames decoded.
+    uint32_t samples; ///< Samples written to the series.
+    uint32_t dropped; ///< Frames missing from the sequence numbers (gaps of up to 127), rejected or never received.
+    uint32_t rejected; ///< Candidate frames failing a check (CRC, length, channels or offset).
+    uint32_t skipped; ///< Bytes skipped looking for the start of a frame.
+    uint32_t overrun; ///< Bytes fed while the receive buffer was full, discarded.
+};
+
+/**
+ * @class Graph_Ingest
+ * @brief Decoder of framed binary samples, written straight into the series of a graph.
+ *
+ * Frames are little-endian: sync (A5 5A), length of what follows up to the CRC (2 bytes),
+ * channels (1), sequence number (1), offset of the first sample (2), then n samples of every
+ * channel, interleaved (uint16_t, sample k of channel c at 2 * (k * channels + c)), and the
+ * CRC-16/CCITT-FALSE of the bytes from the length to the last sample (2). Sample k of channel c is
+ * written at index offset + k of the array bound to channel c, so a long series can arrive in
+ * several frames.
+ *
+ * The bytes are received into a ring over caller-supplied storage, directly by the driver
+ * (receiveBuffer, received) or copied (feed); decode then reads each sample from the ring into
+ * its series, no frame is ever copied. Corrupted frames are dropped and the decoder looks for the
+ * next sync, so the stream recovers by itself. Both calls must come from the same task.
+ */
+class Graph_Ingest
+{
+private:
+    uint8_t *buffer;   ///< Storage of the receive ring.
+    uint32_t capacity; ///< Size of the ring in bytes.
+    uint32_t head;     ///< Position of the first byte not decoded.
+    uint32_t count;    ///< Number of bytes received and not decoded.
+    uint16_t *series[GRAPH_INGEST_CHANNELS]; ///< Array of every channel, NULL if the channel is ignored.
+    uint16_t lengths[GRAPH_INGEST_CHANNELS]; ///< Number of samples of the array of every channel.
+    uint8_t sequence;  ///< Sequence number expected next.
+    bool synced;       ///< Whether a frame was decoded, so that sequence is meaningful.
+    GRAPH_INGEST_COUNTERS counters; ///< Counters since the last reset.
+    GRAPH_INGEST_COUNTERS marked;   ///< Counters at the last measure.
+    uint32_t markedTime;  ///< Time of the last measure, in microseconds.
+    uint32_t byteRate;    ///< Bytes per second between the last two measures.
+    uint32_t frameRate;   ///< Frames per second between the last two measures.
+
+    uint8_t at(uint32_t i) const
+    {
+        uint32_t p = head + i;
+        return buffer[(p >= capacity) ? p - capacity : p];
+    }
+
+    uint16_t at16(uint32_t i) const { return at(i) | (uint16_t)(at(i + 1) << 8); }
+
+    void consume(uint32_t n)
+    {
+        head += n;
+        head = (head >= capacity) ? head - capacity : head;
+        count -= n;
+    }
+
+public:
+    /**
+     * @brief Constructor for the Graph_Ingest class.
+     * @param buffer Storage of the receive ring, at least the largest frame (NULL for an empty decoder).
+     * @param capacity Size of the storage in bytes.
+     */
+    Graph_Ingest(uint8_t *buffer = NULL, uint32_t capacity = 0);
+
+    /**
+     * @brief Set the array receiving the samples of a channel.
+     * @param channel Channel, from 0 to GRAPH_INGEST_CHANNELS - 1.
+     * @param data Array of the series, or NULL to ignore the channel.
+     * @param n Number of samples of the array; frames writing past it are dropped.
+     */
+    void bind(uint8_t channel, uint16_t *data, uint16_t n);
+
+    /**
+     * @brief Set the arrays of the first channels, the same ones given to a multi-series graph.
+     * @param data Array of every channel.
+     * @param channels Number of channels, up to GRAPH_INGEST_CHANNELS.
+     * @param n Number of samples of every array.
+     */
+    void bind(uint16_t *const *data, uint8_t channels, uint16_t n);
+
+    /**
+     * @brief Get the free part of the ring the driver can write into, contiguous up to its end.
+     * @param room Number of bytes that can be written.
+     * @return Where to write them, to be followed by received().
+     */
+    uint8_t *receiveBuffer(uint32_t &room);
+
+    /**
+     * @brief Account bytes written by the driver into receiveBuffer().
+     * @param n Number of bytes, up to the room given.
+     */
+    void received(uint32_t n)
+    {
+        count += n;
+        counters.bytes += n;
+    }
+
+    /**
+     * @brief Copy received bytes into the ring, the ones not fitting are discarded.
+     * @param data Bytes received.
+     * @param n Number of bytes.
+     * @return Number of bytes kept.
+     */
+    uint32_t feed(const uint8_t *data, uint32_t n);
+
+    /**
+     * @brief Decode every complete frame received, writing the samples into the series.
+     * @return Number of frames decoded.
+     */
+    uint32_t decode(void);
+
+    /**
+     * @brief Encode a frame, sender side.
+     * @param out Storage for GRAPH_INGEST_BYTES(channels, n) bytes.
+     * @param room Size of the storage.
+     * @param data Array of every channel, sample k of channel c being data[c][k].
+     * @param channels Number of channels, up to GRAPH_INGEST_CHANNELS.
+     * @param n Number of samples per channel.
+     * @param offset Index of the first sample in the series of the receiver.
+     * @param seq Sequence number, incremented by the sender for every frame.
+     * @return Size of the frame, 0 if it doesn't fit.
+     */
+    static uint32_t encode(uint8_t *out, uint32_t room, const uint16_t *const *data, uint8_t channels, uint16_t n,
+                           uint16_t offset, uint8_t seq);
+
+    /**
+     * @brief Compute the byte and frame rates since the previous measure (or since time 0).
+     * @param now Current time in microseconds (micros()), wrapping around.
+     */
+    void measure(uint32_t now);
+
+    /**
+     * @brief Reset the counters and the rates.
+     */
+    void resetCounters(void);
+
+    const GRAPH_INGEST_COUNTERS &getCounters(void) const { return counters; }
+    uint32_t getByteRate(void) const { return byteRate; }
+    uint32_t getFrameRate(void) const { return frameRate; }
+    uint32_t size(void) const { return count; }
+    uint32_t getCapacity(void) const { return capacity; }
+};
@@ -0,0 +1,467 @@
+#include "Graph_List.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FONT_W 6 // Built-in font cell, as drawn by the targets
+#define FONT_H 8
+
+static inline int16_t clamp16(int32_t v)
+{
+    return (v < -32768) ? -32768 : ((v > 32767) ? 32767 : v);
+}
+
+static inline int32_t min3(int32_t a, int32_t b, int32_t c)
+{
+    int32_t m = (a < b) ? a : b;
+    return (c < m) ? c : m;
+}
+
+static inline int32_t max3(int32_t a, int32_t b, int32_t c)
+{
+    int32_t m = (a > b) ? a : b;
+    return (c > m) ? c : m;
+}
+
+static inline bool touches(const GRAPH_RECT &a, const GRAPH_RECT &b)
+{
+    return a.left <= b.right + 1 && b.left <= a.right + 1 && a.top <= b.bottom + 1 && b.top <= a.bottom + 1;
+}
+
+static inline GRAPH_RECT unite(const GRAPH_RECT &a, const GRAPH_RECT &b)
+{
+    GRAPH_RECT r;
+    r.left = (a.left < b.left) ? a.left : b.left;
+    r.top = (a.top < b.top) ? a.top : b.top;
+    r.right = (a.right > b.right) ? a.right : b.right;
+    r.bottom = (a.bottom > b.bottom) ? a.bottom : b.bottom;
+    return r;
+}
+
+static inline uint32_t area(const GRAPH_RECT &r)
+{
+    return (uint32_t)(r.right - r.left + 1) * (uint32_t)(r.bottom - r.top + 1);
+}
+
+Graph_List::Graph_List(GRAPH_COMMAND *commands, uint16_t capacity)
+{
+    this->commands = commands;
+    this->capacity = (commands != NULL) ? capacity : 0;
+    count = 0;
+    overflowed = false;
+    textSize = 1;
+    textFG = 0xffff;
+    textBG = 0xffff;
+}
+
+GRAPH_COMMAND *Graph_List::add(uint8_t op, uint16_t color, int32_t left, int32_t top, int32_t right, int32_t bottom)
+{
+    countPrimitive();
+    if (count == capacity)
+    {
+        overflowed = true;
+        return NULL;
+    }
+
+    GRAPH_COMMAND *c = &commands[count++];
+    memset(c, 0, sizeof(GRAPH_COMMAND));
+    c->op = op;
+    c->color = color;
+    c->box.left = clamp16(left);
+    c->box.top = clamp16(top);
+    c->box.right = clamp16(right);
+    c->box.bottom = clamp16(bottom);
+    return c;
+}
+
+void Graph_List::drawPixel(int32_t x, int32_t y, uint16_t color)
+{
+    GRAPH_COMMAND *c = add(OP_PIXEL, color, x, y, x, y);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+}
+
+void Graph_List::drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color)
+{
+    if (w <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_HLINE, color, x, y, x + w - 1, y);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = w;
+}
+
+void Graph_List::drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color)
+{
+    if (h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_VLINE, color, x, y, x, y + h - 1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = h;
+}
+
+void Graph_List::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_FILL_RECT, color, x, y, x + w - 1, y + h - 1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = w;
+    c->args.v[3] = h;
+}
+
+void Graph_List::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_RECT, color, x, y, x + w - 1, y + h - 1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = w;
+    c->args.v[3] = h;
+}
+
+void Graph_List::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+{
+    GRAPH_COMMAND *c = add(OP_LINE, color, (x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1, (x0 > x1) ? x0 : x1, (y0 > y1) ? y0 : y1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x0;
+    c->args.v[1] = y0;
+    c->args.v[2] = x1;
+    c->args.v[3] = y1;
+}
+
+void Graph_List::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_ROUND_RECT, color, x, y, x + w - 1, y + h - 1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = w;
+    c->args.v[3] = h;
+    c->args.v[4] = r;
+}
+
+void Graph_List::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_FILL_ROUND_RECT, color, x, y, x + w - 1, y + h - 1);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = w;
+    c->args.v[3] = h;
+    c->args.v[4] = r;
+}
+
+void Graph_List::drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+{
+    GRAPH_COMMAND *c = add(OP_CIRCLE, color, x - r, y - r, x + r, y + r);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = r;
+}
+
+void Graph_List::fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+{
+    GRAPH_COMMAND *c = add(OP_FILL_CIRCLE, color, x - r, y - r, x + r, y + r);
+    if (c == NULL)
+        return;
+    c->args.v[0] = x;
+    c->args.v[1] = y;
+    c->args.v[2] = r;
+}
+
+void Graph_List::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+    GRAPH_COMMAND *c = add(OP_FILL_TRIANGLE, color, min3(x0, x1, x2), min3(y0, y1, y2), max3(x0, x1, x2), max3(y0, y1, y2));
+    if (c == NULL)
+        return;
+    c->args.v[0] = x0;
+    c->args.v[1] = y0;
+    c->args.v[2] = x1;
+    c->args.v[3] = y1;
+    c->args.v[4] = x2;
+    c->args.v[5] = y2;
+}
+
+int16_t Graph_List::addText(const char *string, int32_t x, int32_t y)
+{
+    int32_t cell = FONT_W * textSize;
+    size_t length = strlen(string);
+    for (size_t i = 0; i < length; i += GRAPH_LIST_TEXT)
+    {
+        // Characters are drawn cell by cell, a long string splits into commands drawing the same pixels
+        uint8_t n = (length - i < GRAPH_LIST_TEXT) ? length - i : GRAPH_LIST_TEXT;
+        int32_t left = x + i * cell;
+        GRAPH_COMMAND *c = add(OP_TEXT, textFG, left, y, left + n * cell - 1, y + FONT_H * textSize - 1);
+        if (c == NULL)
+            break;
+        c->length = n;
+        c->args.text.x = left;
+        c->args.text.y = y;
+        c->args.text.bg = textBG;
+        c->args.text.size = textSize;
+        memcpy(c->args.text.text, string + i, n);
+    }
+    return length * cell;
+}
+
+int16_t Graph_List::drawString(const char *string, int32_t x, int32_t y)
+{
+    if (string == NULL)
+    {
+        countPrimitive();
+        return 0;
+    }
+    return addText(string, x, y);
+}
+
+int16_t Graph_List::drawNumber(long value, int32_t x, int32_t y)
+{
+    char str[12];
+    snprintf(str, sizeof(str), "%ld", value);
+    return addText(str, x, y);
+}
+
+void Graph_List::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    GRAPH_COMMAND *c = add(OP_IMAGE, 0, x, y, x + w - 1, y + h - 1);
+    if (c == NULL)
+        return;
+
+    stride = (stride == 0) ? w : stride;
+    c->args.image.data = data;
+    c->args.image.stride = stride;
+
+    // The block is kept by reference, its checksum tells whether it changed
+    uint32_t sum = 2166136261u;
+    for (int32_t j = 0; j < h; j++)
+    {
+        for (int32_t i = 0; i < w; i++)
+            sum = (sum ^ data[j * stride + i]) * 16777619u;
+    }
+    c->args.image.sum = sum;
+}
+
+void Graph_List::setTextSize(uint8_t size)
+{
+    textSize = (size > 0) ? size : 1;
+}
+
+void Graph_List::setTextColor(uint16_t fg, uint16_t bg, bool bgfill)
+{
+    (void)bgfill;
+    textFG = fg;
+    textBG = bg;
+}
+
+void Graph_List::draw(const GRAPH_COMMAND &c, Graph_Target *target)
+{
+    const int16_t *v = c.args.v;
+    switch (c.op)
+    {
+    case OP_PIXEL:
+        target->drawPixel(v[0], v[1], c.color);
+        break;
+    case OP_HLINE:
+        target->drawFastHLine(v[0], v[1], v[2], c.color);
+        break;
+    case OP_VLINE:
+        target->drawFastVLine(v[0], v[1], v[2], c.color);
+        break;
+    case OP_FILL_RECT:
+        target->fillRect(v[0], v[1], v[2], v[3], c.color);
+        break;
+    case OP_RECT:
+        target->drawRect(v[0], v[1], v[2], v[3], c.color);
+        break;
+    case OP_LINE:
+        target->drawLine(v[0], v[1], v[2], v[3], c.color);
+        break;
+    case OP_ROUND_RECT:
+        target->drawRoundRect(v[0], v[1], v[2], v[3], v[4], c.color);
+        break;
+    case OP_FILL_ROUND_RECT:
+        target->fillRoundRect(v[0], v[1], v[2], v[3], v[4], c.color);
+        break;
+    case OP_CIRCLE:
+        target->drawCircle(v[0], v[1], v[2], c.color);
+        break;
+    case OP_FILL_CIRCLE:
+        target->fillCircle(v[0], v[1], v[2], c.color);
+        break;
+    case OP_FILL_TRIANGLE:
+        target->fillTriangle(v[0], v[1], v[2], v[3], v[4], v[5], c.color);
+        break;
+    case OP_TEXT:
+    {
+        char str[GRAPH_LIST_TEXT + 1];
+        memcpy(str, c.args.text.text, c.length);
+        str[c.length] = '\0';
+        target->setTextSize(c.args.text.size);
+        target->setTextColor(c.color, c.args.text.bg, false);
+        target->drawString(str, c.args.text.x, c.args.text.y);
+        break;
+    }
+    case OP_IMAGE:
+        target->pushImage(c.box.left, c.box.top, c.box.right - c.box.left + 1, c.box.bottom - c.box.top + 1,
+                          c.args.image.data, c.args.image.stride);
+        break;
+    }
+}
+
+void Graph_List::replay(Graph_Target *target, const GRAPH_RECT &area) const
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const GRAPH_RECT &b = commands[i].box;
+        if (b.right < area.left || b.left > area.right || b.bottom < area.top || b.top > area.bottom)
+            continue;
+        draw(commands[i], target);
+    }
+}
+
+void Graph_List::replay(Graph_Target *target) const
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        draw(commands[i], target);
+    }
+}
+
+uint32_t Graph_List::hash(const GRAPH_COMMAND &c)
+{
+    // FNV-1a, commands are cleared before being filled so equal commands have equal bytes
+    const uint8_t *p = (const uint8_t *)&c;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(GRAPH_COMMAND); i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+uint8_t Graph_List::addRect(GRAPH_RECT *rects, uint8_t n, uint8_t max, GRAPH_RECT rect)
+{
+    // Swallow the rectangles touched, again as long as growing touches new ones
+    for (uint8_t i = 0; i < n;)
+    {
+        if (touches(rects[i], rect))
+        {
+            rect = unite(rects[i], rect);
+            rects[i] = rects[--n];
+            i = 0;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    if (n < max)
+    {
+        rects[n++] = rect;
+        return n;
+    }
+
+    uint8_t best = 0;
+    uint32_t bestGrowth = 0xffffffff;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        uint32_t growth = area(unite(rects[i], rect)) - area(rects[i]);
+        if (growth < bestGrowth)
+        {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    rects[best] = unite(rects[best], rect);
+    return n;
+}
+
+uint8_t Graph_List::diff(const Graph_List &previous, GRAPH_RECT *rects, uint8_t max, Graph_Arena &scratch) const
+{
+    max = (max < GRAPH_LIST_RECTS) ? max : GRAPH_LIST_RECTS;
+    uint8_t n = 0;
+
+    // Open addressing table of the previous commands, at most half full
+    uint32_t slots = 2;
+    while (slots < 2u * previous.count)
+        slots <<= 1;
+    uint32_t mask = slots - 1;
+
+    size_t mark = scratch.mark();
+    uint16_t *table = scratch.alloc<uint16_t>(slots);
+    uint8_t *matched = scratch.alloc<uint8_t>(previous.count + 1);
+    if (table == NULL || matched == NULL)
+    {
+        scratch.release(mark);
+        for (uint16_t i = 0; i < previous.count; i++)
+            n = addRect(rects, n, max, previous.commands[i].box);
+        for (uint16_t i = 0; i < count; i++)
+            n = addRect(rects, n, max, commands[i].box);
+        return n;
+    }
+
+    memset(table, 0, slots * sizeof(uint16_t));
+    memset(matched, 0, previous.count);
+    for (uint16_t i = 0; i < previous.count; i++)
+    {
+        uint32_t s = hash(previous.commands[i]) & mask;
+        while (table[s] != 0)
+            s = (s + 1) & mask;
+        table[s] = i + 1;
+    }
+
+    // New commands, commands drawn differently, and commands drawn before one they followed
+    int32_t last = -1;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        int32_t found = -1;
+        for (uint32_t s = hash(commands[i]) & mask; table[s] != 0; s = (s + 1) & mask)
+        {
+            uint16_t j = table[s] - 1;
+            if (!matched[j] && memcmp(&previous.commands[j], &commands[i], sizeof(GRAPH_COMMAND)) == 0)
+            {
+                matched[j] = 1;
+                found = j;
+                break;
+            }
+        }
+        // A command moved back in the painter's order may now be covered, its box is drawn again
+        if (found < 0 || found < last)
+            n = addRect(rects, n, max, commands[i].box);
+        else
+            last = found;
+    }
+
+    // Commands gone
+    for (uint16_t i = 0; i < previous.count; i++)
+    {
+        if (!matched[i])
+            n = addRect(rects, n, max, previous.commands[i].box);
+    }
+
+    scratch.release(mark);
+    return n;
+}
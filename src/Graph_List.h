@@ -0,0 +1,196 @@
+#pragma once
+#include "Graph_Target.h"
+#include "Graph_Arena.h"
+
+#define GRAPH_LIST_TEXT 8  ///< Characters held by a text command, longer strings take several commands.
+#define GRAPH_LIST_RECTS 8 ///< Maximum number of changed rectangles found by a diff.
+
+/**
+ * @struct GRAPH_RECT
+ * @brief Rectangle in screen coordinates, edges included.
+ */
+struct GRAPH_RECT
+{
+    int16_t left;
+    int16_t top;
+    int16_t right;
+    int16_t bottom;
+};
+
+/**
+ * @struct GRAPH_TEXT_ARGS
+ * @brief Arguments of a text command.
+ */
+struct GRAPH_TEXT_ARGS
+{
+    int16_t x;                   ///< Screen X-coordinate of the first character.
+    int16_t y;                   ///< Screen Y-coordinate of the characters.
+    uint16_t bg;                 ///< Background colour (same as the colour for transparent text).
+    uint8_t size;                ///< Font scale factor.
+    char text[GRAPH_LIST_TEXT]; ///< Characters, not terminated.
+};
+
+/**
+ * @struct GRAPH_IMAGE_ARGS
+ * @brief Arguments of an image command, the block itself being kept by reference.
+ */
+struct GRAPH_IMAGE_ARGS
+{
+    const uint16_t *data; ///< Pixels of the block.
+    int32_t stride;       ///< Distance in pixels between two rows of data.
+    uint32_t sum;         ///< Checksum of the pixels when recorded.
+};
+
+/**
+ * @struct GRAPH_COMMAND
+ * @brief One drawing call recorded in a Graph_List.
+ */
+struct GRAPH_COMMAND
+{
+    uint8_t op;       ///< Graph_Target call recorded.
+    uint8_t length;   ///< Number of characters of a text command.
+    uint16_t color;   ///< Colour of the call.
+    GRAPH_RECT box;   ///< Pixels the call may touch.
+    union
+    {
+        int16_t v[6];          ///< Coordinates and sizes, in the order of the call.
+        GRAPH_TEXT_ARGS text;   ///< Text commands.
+        GRAPH_IMAGE_ARGS image; ///< Image commands.
+    } args;
+};
+
+/**
+ * @class Graph_List
+ * @brief Drawing target recording the calls of a frame into caller-supplied storage.
+ *
+ * A frame recorded as a display list can be compared with the previous one: diff() returns the
+ * areas where the two frames differ, and replay() draws again the calls crossing an area, so only
+ * what changed is rasterized and sent. Images are kept by reference and must stay valid until the
+ * list is replayed. A frame with more calls than the capacity is marked overflowed.
+ */
+class Graph_List : public Graph_Target
+{
+private:
+    enum
+    {
+        OP_PIXEL,
+        OP_HLINE,
+        OP_VLINE,
+        OP_FILL_RECT,
+        OP_RECT,
+        OP_LINE,
+        OP_ROUND_RECT,
+        OP_FILL_ROUND_RECT,
+        OP_CIRCLE,
+        OP_FILL_CIRCLE,
+        OP_FILL_TRIANGLE,
+        OP_TEXT,
+        OP_IMAGE
+    };
+
+    GRAPH_COMMAND *commands; ///< Storage for capacity commands.
+    uint16_t capacity;       ///< Maximum number of commands.
+    uint16_t count;          ///< Number of commands recorded.
+    bool overflowed;         ///< Whether a call was dropped since the last clear.
+    uint8_t textSize;        ///< Font scale factor.
+    uint16_t textFG;         ///< Text colour.
+    uint16_t textBG;         ///< Text background colour.
+
+    /**
+     * @brief Append a command, cleared but for its operation, colour and bounding box.
+     * @return The command, NULL if the list is full.
+     */
+    GRAPH_COMMAND *add(uint8_t op, uint16_t color, int32_t left, int32_t top, int32_t right, int32_t bottom);
+
+    /**
+     * @brief Record a string as text commands of up to GRAPH_LIST_TEXT characters.
+     * @return Width of the string in px.
+     */
+    int16_t addText(const char *string, int32_t x, int32_t y);
+
+    /**
+     * @brief Draw one command on a target.
+     */
+    static void draw(const GRAPH_COMMAND &c, Graph_Target *target);
+
+    static uint32_t hash(const GRAPH_COMMAND &c);
+
+public:
+    /**
+     * @brief Constructor for the Graph_List class.
+     * @param commands Storage for capacity commands (NULL for an empty list).
+     * @param capacity Maximum number of commands of a frame.
+     */
+    Graph_List(GRAPH_COMMAND *commands = NULL, uint16_t capacity = 0);
+
+    void drawPixel(int32_t x, int32_t y, uint16_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color);
+    int16_t drawString(const char *string, int32_t x, int32_t y);
+    int16_t drawNumber(long value, int32_t x, int32_t y);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride = 0);
+    void setTextSize(uint8_t size);
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false);
+
+    /**
+     * @brief Remove every command.
+     */
+    void clear(void)
+    {
+        count = 0;
+        overflowed = false;
+    }
+
+    /**
+     * @brief Draw again the commands crossing a rectangle, in the recorded order.
+     *
+     * The target is expected to clip to the rectangle, a Graph_Raster covering it for instance.
+     * @param target Target receiving the calls.
+     * @param area Rectangle to draw.
+     */
+    void replay(Graph_Target *target, const GRAPH_RECT &area) const;
+
+    /**
+     * @brief Draw again every command, in the recorded order.
+     */
+    void replay(Graph_Target *target) const;
+
+    /**
+     * @brief Find the areas where this frame differs from a previous one.
+     *
+     * A command drawn identically in both frames, in the same order relative to the others, is
+     * left out; the bounding boxes of the others, gone, new or moved in the drawing order, are
+     * merged into at most max rectangles. Without scratch memory for the matching
+     * (4 bytes per command of the previous list), every command is taken as changed.
+     * @param previous List of the previous frame.
+     * @param rects Changed rectangles.
+     * @param max Maximum number of rectangles, up to GRAPH_LIST_RECTS.
+     * @param scratch Scratch memory, released before returning.
+     * @return Number of rectangles, 0 if the frames are the same.
+     */
+    uint8_t diff(const Graph_List &previous, GRAPH_RECT *rects, uint8_t max, Graph_Arena &scratch) const;
+
+    /**
+     * @brief Add a rectangle to a set, merging it with the ones it touches.
+     *
+     * With max rectangles already, it grows the one whose area grows the least.
+     * @param rects Set of rectangles.
+     * @param n Number of rectangles of the set.
+     * @param max Maximum number of rectangles.
+     * @param rect Rectangle to add.
+     * @return New number of rectangles.
+     */
+    static uint8_t addRect(GRAPH_RECT *rects, uint8_t n, uint8_t max, GRAPH_RECT rect);
+
+    uint16_t size(void) const { return count; }
+    uint16_t getCapacity(void) const { return capacity; }
+    bool isOverflowed(void) const { return overflowed; }
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define GRAPH_CACHE_LINE 64 ///< Distance kept between the indices of the producer and the consumer.
+
+/**
+ * @class Graph_Queue
+ * @brief Lock-free single-producer single-consumer queue over caller-supplied storage.
+ *
+ * One task (or ISR) pushes while another one, possibly on the other core, pops: no lock is taken
+ * and no element is ever lost or torn. The producer publishes an element with a release store of
+ * its index, the consumer frees a slot with a release store of its own, each side only reads the
+ * index of the other with an acquire load. A push into a full queue fails and is counted, the
+ * producer decides whether to retry or drop.
+ * @tparam T Type of the elements, copied by value.
+ */
+template <typename T>
+class Graph_Queue
+{
+private:
+    T *buffer;         ///< Storage for capacity elements.
+    uint32_t capacity; ///< Maximum number of elements.
+    std::atomic<uint32_t> tail; ///< Position of the next push, written by the producer only.
+    std::atomic<uint32_t> failed; ///< Number of pushes into a full queue, written by the producer only.
+    uint8_t pad[GRAPH_CACHE_LINE]; ///< Keeps the indices of the two sides on different cache lines.
+    std::atomic<uint32_t> head; ///< Position of the next pop, written by the consumer only.
+
+    /* Positions run over twice the capacity, so that a full queue and an empty one differ */
+    uint32_t count(uint32_t h, uint32_t t) const { return (t >= h) ? t - h : t + 2 * capacity - h; }
+    uint32_t slot(uint32_t position) const { return (position >= capacity) ? position - capacity : position; }
+    uint32_t advance(uint32_t position, uint32_t n) const
+    {
+        position += n;
+        return (position >= 2 * capacity) ? position - 2 * capacity : position;
+    }
+
+public:
+    /**
+     * @brief Constructor for the Graph_Queue class.
+     * @param buffer Storage for capacity elements (NULL for an empty queue).
+     * @param capacity Maximum number of elements.
+     */
+    Graph_Queue(T *buffer = NULL, uint32_t capacity = 0)
+        : buffer(buffer), capacity(buffer ? capacity : 0), tail(0), failed(0), head(0)
+    {
+        (void)pad;
+    }
+
+    Graph_Queue(const Graph_Queue &) = delete;
+    Graph_Queue &operator=(const Graph_Queue &) = delete;
+
+    /**
+     * @brief Append an element, producer side.
+     * @param value Element to append.
+     * @return false if the queue is full, the element is not appended.
+     */
+    bool push(const T &value)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (count(head.load(std::memory_order_acquire), t) >= capacity)
+        {
+            failed.store(failed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        buffer[slot(t)] = value;
+        tail.store(advance(t, 1), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element, consumer side.
+     * @param value Element removed.
+     * @return false if the queue is empty.
+     */
+    bool pop(T &value)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        value = buffer[slot(h)];
+        head.store(advance(h, 1), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove up to n of the oldest elements at once, consumer side.
+     * @param values Elements removed.
+     * @param n Maximum number of elements to remove.
+     * @return Number of elements removed.
+     */
+    uint32_t pop(T *values, uint32_t n)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t available = count(h, tail.load(std::memory_order_acquire));
+        n = (n < available) ? n : available;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            values[i] = buffer[slot(advance(h, i))];
+        }
+        head.store(advance(h, n), std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Get the number of elements held, a snapshot while the other side is running.
+     */
+    uint32_t size(void) const { return count(head.load(std::memory_order_acquire), tail.load(std::memory_order_acquire)); }
+
+    uint32_t getCapacity(void) const { return capacity; }
+
+    /**
+     * @brief Get the number of pushes that failed because the queue was full.
+     */
+    uint32_t getFailed(void) const { return failed.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,895 @@
+#include "Graph_Raster.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FONT_W 6 // 5 columns + 1 column of spacing
+#define FONT_H 8
+#define FONT_FIRST 0x20
+#define FONT_LAST 0x7e
+
+/* Classic 5x7 GLCD font (TFT_eSPI font 1), one byte per column, LSB at the top */
+static const uint8_t font5x7[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, // space
+    0x00, 0x00, 0x5F, 0x00, 0x00, // !
+    0x00, 0x07, 0x00, 0x07, 0x00, // "
+    0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+    0x23, 0x13, 0x08, 0x64, 0x62, // %
+    0x36, 0x49, 0x55, 0x22, 0x50, // &
+    0x00, 0x05, 0x03, 0x00, 0x00, // '
+    0x00, 0x1C, 0x22, 0x41, 0x00, // (
+    0x00, 0x41, 0x22, 0x1C, 0x00, // )
+    0x08, 0x2A, 0x1C, 0x2A, 0x08, // *
+    0x08, 0x08, 0x3E, 0x08, 0x08, // +
+    0x00, 0x50, 0x30, 0x00, 0x00, // ,
+    0x08, 0x08, 0x08, 0x08, 0x08, // -
+    0x00, 0x60, 0x60, 0x00, 0x00, // .
+    0x20, 0x10, 0x08, 0x04, 0x02, // /
+    0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+    0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+    0x42, 0x61, 0x51, 0x49, 0x46, // 2
+    0x21, 0x41, 0x45, 0x4B, 0x31, // 3
+    0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+    0x27, 0x45, 0x45, 0x45, 0x39, // 5
+    0x3C, 0x4A, 0x49, 0x49, 0x30, // 6
+    0x01, 0x71, 0x09, 0x05, 0x03, // 7
+    0x36, 0x49, 0x49, 0x49, 0x36, // 8
+    0x06, 0x49, 0x49, 0x29, 0x1E, // 9
+    0x00, 0x36, 0x36, 0x00, 0x00, // :
+    0x00, 0x56, 0x36, 0x00, 0x00, // ;
+    0x00, 0x08, 0x14, 0x22, 0x41, // <
+    0x14, 0x14, 0x14, 0x14, 0x14, // =
+    0x41, 0x22, 0x14, 0x08, 0x00, // >
+    0x02, 0x01, 0x51, 0x09, 0x06, // ?
+    0x32, 0x49, 0x79, 0x41, 0x3E, // @
+    0x7E, 0x11, 0x11, 0x11, 0x7E, // A
+    0x7F, 0x49, 0x49, 0x49, 0x36, // B
+    0x3E, 0x41, 0x41, 0x41, 0x22, // C
+    0x7F, 0x41, 0x41, 0x22, 0x1C, // D
+    0x7F, 0x49, 0x49, 0x49, 0x41, // E
+    0x7F, 0x09, 0x09, 0x01, 0x01, // F
+    0x3E, 0x41, 0x41, 0x51, 0x32, // G
+    0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+    0x00, 0x41, 0x7F, 0x41, 0x00, // I
+    0x20, 0x40, 0x41, 0x3F, 0x01, // J
+    0x7F, 0x08, 0x14, 0x22, 0x41, // K
+    0x7F, 0x40, 0x40, 0x40, 0x40, // L
+    0x7F, 0x02, 0x04, 0x02, 0x7F, // M
+    0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+    0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+    0x7F, 0x09, 0x09, 0x09, 0x06, // P
+    0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+    0x7F, 0x09, 0x19, 0x29, 0x46, // R
+    0x46, 0x49, 0x49, 0x49, 0x31, // S
+    0x01, 0x01, 0x7F, 0x01, 0x01, // T
+    0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+    0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+    0x7F, 0x20, 0x18, 0x20, 0x7F, // W
+    0x63, 0x14, 0x08, 0x14, 0x63, // X
+    0x03, 0x04, 0x78, 0x04, 0x03, // Y
+    0x61, 0x51, 0x49, 0x45, 0x43, // Z
+    0x00, 0x00, 0x7F, 0x41, 0x41, // [
+    0x02, 0x04, 0x08, 0x10, 0x20, // backslash
+    0x41, 0x41, 0x7F, 0x00, 0x00, // ]
+    0x04, 0x02, 0x01, 0x02, 0x04, // ^
+    0x40, 0x40, 0x40, 0x40, 0x40, // _
+    0x00, 0x01, 0x02, 0x04, 0x00, // `
+    0x20, 0x54, 0x54, 0x54, 0x78, // a
+    0x7F, 0x48, 0x44, 0x44, 0x38, // b
+    0x38, 0x44, 0x44, 0x44, 0x20, // c
+    0x38, 0x44, 0x44, 0x48, 0x7F, // d
+    0x38, 0x54, 0x54, 0x54, 0x18, // e
+    0x08, 0x7E, 0x09, 0x01, 0x02, // f
+    0x08, 0x14, 0x54, 0x54, 0x3C, // g
+    0x7F, 0x08, 0x04, 0x04, 0x78, // h
+    0x00, 0x44, 0x7D, 0x40, 0x00, // i
+    0x20, 0x40, 0x44, 0x3D, 0x00, // j
+    0x00, 0x7F, 0x10, 0x28, 0x44, // k
+    0x00, 0x41, 0x7F, 0x40, 0x00, // l
+    0x7C, 0x04, 0x18, 0x04, 0x78, // m
+    0x7C, 0x08, 0x04, 0x04, 0x78, // n
+    0x38, 0x44, 0x44, 0x44, 0x38, // o
+    0x7C, 0x14, 0x14, 0x14, 0x08, // p
+    0x08, 0x14, 0x14, 0x18, 0x7C, // q
+    0x7C, 0x08, 0x04, 0x04, 0x08, // r
+    0x48, 0x54, 0x54, 0x54, 0x20, // s
+    0x04, 0x3F, 0x44, 0x40, 0x20, // t
+    0x3C, 0x40, 0x40, 0x20, 0x7C, // u
+    0x1C, 0x20, 0x40, 0x20, 0x1C, // v
+    0x3C, 0x40, 0x30, 0x40, 0x3C, // w
+    0x44, 0x28, 0x10, 0x28, 0x44, // x
+    0x0C, 0x50, 0x50, 0x50, 0x3C, // y
+    0x44, 0x64, 0x54, 0x4C, 0x44, // z
+    0x00, 0x08, 0x36, 0x41, 0x00, // {
+    0x00, 0x00, 0x7F, 0x00, 0x00, // |
+    0x00, 0x41, 0x36, 0x08, 0x00, // }
+    0x08, 0x04, 0x08, 0x10, 0x08, // ~
+};
+
+static inline void swapInt(int32_t &a, int32_t &b)
+{
+    int32_t t = a;
+    a = b;
+    b = t;
+}
+
+Graph_Raster::Graph_Raster(uint16_t *buffer, uint16_t width, uint16_t height, int32_t x, int32_t y)
+{
+    this->buffer = buffer;
+    indices = NULL;
+    depth = 16;
+    stride = 0;
+    palette = NULL;
+    paletteSize = 0;
+    paletteUsed = 0;
+    lastIndex = 0;
+    this->width = width;
+    this->height = height;
+    originX = x;
+    originY = y;
+    textSize = 1;
+    textFG = 0xffff;
+    textBG = 0xffff;
+}
+
+Graph_Raster::Graph_Raster(uint8_t *buffer, uint8_t bpp, uint16_t *palette, uint16_t width, uint16_t height, int32_t x, int32_t y)
+{
+    this->buffer = NULL;
+    depth = (bpp == 4) ? 4 : 8;
+    indices = (palette != NULL) ? buffer : NULL;
+    stride = ((uint32_t)width * depth + 7) / 8;
+    this->palette = palette;
+    paletteSize = 1 << depth;
+    paletteUsed = 0;
+    lastIndex = 0;
+    this->width = width;
+    this->height = height;
+    originX = x;
+    originY = y;
+    textSize = 1;
+    textFG = 0xffff;
+    textBG = 0xffff;
+}
+
+uint8_t Graph_Raster::lookup(uint16_t color)
+{
+    if (lastIndex < paletteUsed && palette[lastIndex] == color)
+        return lastIndex;
+
+    for (uint16_t i = 0; i < paletteUsed; i++)
+    {
+        if (palette[i] == color)
+            return lastIndex = i;
+    }
+
+    if (paletteUsed < paletteSize)
+    {
+        palette[paletteUsed] = color;
+        return lastIndex = paletteUsed++;
+    }
+
+    // Palette full: closest entry, green weighted most like the eye does
+    uint32_t best = 0xffffffff;
+    uint8_t found = 0;
+    for (uint16_t i = 0; i < paletteUsed; i++)
+    {
+        int32_t dr = (((int32_t)(palette[i] >> 11) & 0x1f) - ((color >> 11) & 0x1f)) * 2;
+        int32_t dg = ((int32_t)(palette[i] >> 5) & 0x3f) - ((color >> 5) & 0x3f);
+        int32_t db = (((int32_t)palette[i] & 0x1f) - (color & 0x1f)) * 2;
+        uint32_t d = 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+        if (d < best)
+        {
+            best = d;
+            found = i;
+        }
+    }
+    return lastIndex = found;
+}
+
+void Graph_Raster::fillIndex(int32_t x, int32_t y, int32_t w, uint8_t index)
+{
+    uint8_t *row = indices + (uint32_t)y * stride;
+    if (depth == 8)
+    {
+        memset(row + x, index, w);
+        return;
+    }
+
+    // Odd first and last pixels share their byte, whole bytes in between
+    if (x & 1)
+    {
+        putIndex(x++, y, index);
+        w--;
+    }
+    if (w <= 0)
+        return;
+    if (w & 1)
+        putIndex(x + w - 1, y, index);
+    memset(row + (x >> 1), index * 0x11, w >> 1);
+}
+
+void Graph_Raster::span(int32_t x, int32_t y, int32_t w, uint16_t color)
+{
+    x -= originX;
+    y -= originY;
+    if (y < 0 || y >= height || w <= 0)
+        return;
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (w <= 0)
+        return;
+
+    if (indices != NULL)
+    {
+        fillIndex(x, y, w, lookup(color));
+    }
+    else
+    {
+        uint16_t *p = buffer + (uint32_t)y * width + x;
+        for (int32_t i = 0; i < w; i++)
+            p[i] = color;
+    }
+
+    countPixels(w, 1);
+}
+
+void Graph_Raster::vspan(int32_t x, int32_t y, int32_t h, uint16_t color)
+{
+    x -= originX;
+    y -= originY;
+    if (x < 0 || x >= width || h <= 0)
+        return;
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (y + h > height)
+        h = height - y;
+    if (h <= 0)
+        return;
+
+    if (indices != NULL)
+    {
+        uint8_t index = lookup(color);
+        for (int32_t i = 0; i < h; i++)
+            putIndex(x, y + i, index);
+    }
+    else
+    {
+        uint16_t *p = buffer + (uint32_t)y * width + x;
+        for (int32_t i = 0; i < h; i++, p += width)
+            *p = color;
+    }
+
+    countPixels(h, 1);
+}
+
+void Graph_Raster::block(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    x -= originX;
+    y -= originY;
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (y + h > height)
+        h = height - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    if (indices != NULL)
+    {
+        uint8_t index = lookup(color);
+        for (int32_t j = 0; j < h; j++)
+            fillIndex(x, y + j, w, index);
+    }
+    else
+    {
+        for (int32_t j = 0; j < h; j++)
+        {
+            uint16_t *p = buffer + (uint32_t)(y + j) * width + x;
+            for (int32_t i = 0; i < w; i++)
+                p[i] = color;
+        }
+    }
+
+    countPixels(w * h, 1);
+}
+
+void Graph_Raster::drawPixel(int32_t x, int32_t y, uint16_t color)
+{
+    countPrimitive();
+    span(x, y, 1, color);
+}
+
+void Graph_Raster::drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color)
+{
+    countPrimitive();
+    span(x, y, w, color);
+}
+
+void Graph_Raster::drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color)
+{
+    countPrimitive();
+    vspan(x, y, h, color);
+}
+
+void Graph_Raster::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    countPrimitive();
+    block(x, y, w, h, color);
+}
+
+void Graph_Raster::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    countPrimitive();
+    span(x, y, w, color);
+    span(x, y + h - 1, w, color);
+    vspan(x, y + 1, h - 2, color);
+    vspan(x + w - 1, y + 1, h - 2, color);
+}
+
+void Graph_Raster::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+{
+    countPrimitive();
+
+    // Bresenham, emitting each run of pixels as a single span like TFT_eSPI does
+    bool steep = ((y1 > y0) ? y1 - y0 : y0 - y1) > ((x1 > x0) ? x1 - x0 : x0 - x1);
+    if (steep)
+    {
+        swapInt(x0, y0);
+        swapInt(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        swapInt(x0, x1);
+        swapInt(y0, y1);
+    }
+
+    int32_t dx = x1 - x0;
+    int32_t dy = (y1 > y0) ? y1 - y0 : y0 - y1;
+    int32_t err = dx >> 1;
+    int32_t ystep = (y0 < y1) ? 1 : -1;
+    int32_t run = 0;
+    int32_t runStart = x0;
+
+    for (; x0 <= x1; x0++)
+    {
+        run++;
+        err -= dy;
+        if (err < 0 || x0 == x1)
+        {
+            if (steep)
+                vspan(y0, runStart, run, color);
+            else
+                span(runStart, y0, run, color);
+            run = 0;
+            runStart = x0 + 1;
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+}
+
+void Graph_Raster::circleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, uint16_t color)
+{
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -2 * r;
+    int32_t x = 0;
+    int32_t y = r;
+
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (corners & 0x4)
+        {
+            span(x0 + x, y0 + y, 1, color);
+            span(x0 + y, y0 + x, 1, color);
+        }
+        if (corners & 0x2)
+        {
+            span(x0 + x, y0 - y, 1, color);
+            span(x0 + y, y0 - x, 1, color);
+        }
+        if (corners & 0x8)
+        {
+            span(x0 - y, y0 + x, 1, color);
+            span(x0 - x, y0 + y, 1, color);
+        }
+        if (corners & 0x1)
+        {
+            span(x0 - y, y0 - x, 1, color);
+            span(x0 - x, y0 - y, 1, color);
+        }
+    }
+}
+
+void Graph_Raster::fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, int32_t delta, uint16_t color)
+{
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -r - r;
+    int32_t y = 0;
+
+    delta++;
+
+    while (y < r)
+    {
+        if (f >= 0)
+        {
+            if (corners & 0x1)
+                span(x0 - y, y0 + r, y + y + delta, color);
+            if (corners & 0x2)
+                span(x0 - y, y0 - r, y + y + delta, color);
+            r--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+
+        y++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (corners & 0x1)
+            span(x0 - r, y0 + y, r + r + delta, color);
+        if (corners & 0x2)
+            span(x0 - r, y0 - y, r + r + delta, color);
+    }
+}
+
+void Graph_Raster::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    countPrimitive();
+
+    int32_t maxR = ((w < h) ? w : h) / 2;
+    r = (r > maxR) ? maxR : r;
+
+    span(x + r, y, w - r - r, color);
+    span(x + r, y + h - 1, w - r - r, color);
+    vspan(x, y + r, h - r - r, color);
+    vspan(x + w - 1, y + r, h - r - r, color);
+    circleHelper(x + r, y + r, r, 1, color);
+    circleHelper(x + w - r - 1, y + r, r, 2, color);
+    circleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    circleHelper(x + r, y + h - r - 1, r, 8, color);
+}
+
+void Graph_Raster::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    countPrimitive();
+
+    int32_t maxR = ((w < h) ? w : h) / 2;
+    r = (r > maxR) ? maxR : r;
+
+    block(x, y + r, w, h - r - r, color);
+    fillCircleHelper(x + r, y + h - r - 1, r, 1, w - r - r - 1, color);
+    fillCircleHelper(x + r, y + r, r, 2, w - r - r - 1, color);
+}
+
+void Graph_Raster::drawCircle(int32_t x0, int32_t y0, int32_t r, uint16_t color)
+{
+    countPrimitive();
+
+    span(x0, y0 + r, 1, color);
+    span(x0, y0 - r, 1, color);
+    span(x0 + r, y0, 1, color);
+    span(x0 - r, y0, 1, color);
+    circleHelper(x0, y0, r, 0xf, color);
+}
+
+void Graph_Raster::fillCircle(int32_t x0, int32_t y0, int32_t r, uint16_t color)
+{
+    countPrimitive();
+
+    int32_t x = 0;
+    int32_t dx = 1;
+    int32_t dy = r + r;
+    int32_t p = -(r >> 1);
+
+    span(x0 - r, y0, dy + 1, color);
+
+    while (x < r)
+    {
+        if (p >= 0)
+        {
+            span(x0 - x, y0 + r, 2 * x + 1, color);
+            span(x0 - x, y0 - r, 2 * x + 1, color);
+            dy -= 2;
+            p -= dy;
+            r--;
+        }
+
+        dx += 2;
+        p += dx;
+        x++;
+
+        span(x0 - r, y0 + x, 2 * r + 1, color);
+        span(x0 - r, y0 - x, 2 * r + 1, color);
+    }
+}
+
+void Graph_Raster::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+    countPrimitive();
+
+    // Sort coordinates by Y order (y2 >= y1 >= y0)
+    if (y0 > y1)
+    {
+        swapInt(y0, y1);
+        swapInt(x0, x1);
+    }
+    if (y1 > y2)
+    {
+        swapInt(y2, y1);
+        swapInt(x2, x1);
+    }
+    if (y0 > y1)
+    {
+        swapInt(y0, y1);
+        swapInt(x0, x1);
+    }
+
+    int32_t a, b, y, last;
+
+    if (y0 == y2) // All on the same line
+    {
+        a = b = x0;
+        if (x1 < a)
+            a = x1;
+        else if (x1 > b)
+            b = x1;
+        if (x2 < a)
+            a = x2;
+        else if (x2 > b)
+            b = x2;
+        span(a, y0, b - a + 1, color);
+        return;
+    }
+
+    int32_t dx01 = x1 - x0, dy01 = y1 - y0;
+    int32_t dx02 = x2 - x0, dy02 = y2 - y0;
+    int32_t dx12 = x2 - x1, dy12 = y2 - y1;
+    int32_t sa = 0, sb = 0;
+
+    last = (y1 == y2) ? y1 : y1 - 1;
+
+    for (y = y0; y <= last; y++)
+    {
+        a = x0 + sa / dy01;
+        b = x0 + sb / dy02;
+        sa += dx01;
+        sb += dx02;
+        if (a > b)
+            swapInt(a, b);
+        span(a, y, b - a + 1, color);
+    }
+
+    sa = dx12 * (y - y1);
+    sb = dx02 * (y - y0);
+    for (; y <= y2; y++)
+    {
+        a = x1 + sa / dy12;
+        b = x0 + sb / dy02;
+        sa += dx12;
+        sb += dx02;
+        if (a > b)
+            swapInt(a, b);
+        span(a, y, b - a + 1, color);
+    }
+}
+
+int16_t Graph_Raster::drawChar(char c, int32_t x, int32_t y)
+{
+    if (c < FONT_FIRST || c > FONT_LAST)
+        c = '?';
+    const uint8_t *glyph = font5x7 + (c - FONT_FIRST) * (FONT_W - 1);
+    int32_t s = textSize;
+
+    if (textFG != textBG)
+    {
+        // Opaque text: the whole cell goes out as one address window
+        uint32_t written = 0;
+        for (int32_t col = 0; col < FONT_W; col++)
+        {
+            uint8_t bits = (col < FONT_W - 1) ? glyph[col] : 0;
+            for (int32_t row = 0; row < FONT_H; row++)
+            {
+                uint16_t color = (bits & (1 << row)) ? textFG : textBG;
+                for (int32_t j = 0; j < s; j++)
+                {
+                    int32_t py = y + row * s + j - originY;
+                    if (py < 0 || py >= height)
+                        continue;
+                    for (int32_t i = 0; i < s; i++)
+                    {
+                        int32_t px = x + col * s + i - originX;
+                        if (px < 0 || px >= width)
+                            continue;
+                        if (indices != NULL)
+                            putIndex(px, py, lookup(color));
+                        else
+                            buffer[(uint32_t)py * width + px] = color;
+                        written++;
+                    }
+                }
+            }
+        }
+        if (written)
+            countPixels(written, 1);
+    }
+    else
+    {
+        // Transparent text: only the set pixels are written
+        for (int32_t col = 0; col < FONT_W - 1; col++)
+        {
+            uint8_t bits = glyph[col];
+            for (int32_t row = 0; row < FONT_H; row++)
+            {
+                if (bits & (1 << row))
+                {
+                    block(x + col * s, y + row * s, s, s, textFG);
+                }
+            }
+        }
+    }
+
+    return FONT_W * s;
+}
+
+int16_t Graph_Raster::drawString(const char *string, int32_t x, int32_t y)
+{
+    countPrimitive();
+
+    int16_t w = 0;
+    if (string == NULL)
+        return 0;
+    while (*string)
+    {
+        w += drawChar(*string++, x + w, y);
+    }
+    return w;
+}
+
+int16_t Graph_Raster::drawNumber(long value, int32_t x, int32_t y)
+{
+    char str[12];
+    snprintf(str, sizeof(str), "%ld", value);
+    return drawString(str, x, y);
+}
+
+void Graph_Raster::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride)
+{
+    countPrimitive();
+
+    if (stride == 0)
+        stride = w;
+
+    // Clip the block to the buffer, skipping the matching source pixels
+    x -= originX;
+    y -= originY;
+    if (x < 0)
+    {
+        data -= x;
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        data -= y * stride;
+        h += y;
+        y = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (y + h > height)
+        h = height - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    if (indices != NULL)
+    {
+        for (int32_t j = 0; j < h; j++)
+        {
+            for (int32_t i = 0; i < w; i++)
+                putIndex(x + i, y + j, lookup(data[j * stride + i]));
+        }
+    }
+    else
+    {
+        for (int32_t j = 0; j < h; j++)
+        {
+            memcpy(buffer + (uint32_t)(y + j) * width + x, data + j * stride, w * sizeof(uint16_t));
+        }
+    }
+
+    countPixels(w * h, 1);
+}
+
+void Graph_Raster::pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                               uint8_t bpp, const uint16_t *palette)
+{
+    countPrimitive();
+
+    // Clip the block to the buffer, skipping the matching source pixels
+    x -= originX;
+    y -= originY;
+    if (x < 0)
+    {
+        first -= x;
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        data -= y * stride;
+        h += y;
+        y = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (y + h > height)
+        h = height - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    uint16_t pixels[GRAPH_EXPAND_PIXELS];
+    for (int32_t j = 0; j < h; j++)
+    {
+        for (int32_t i = 0; i < w; i += GRAPH_EXPAND_PIXELS)
+        {
+            int32_t n = (w - i < GRAPH_EXPAND_PIXELS) ? w - i : GRAPH_EXPAND_PIXELS;
+            graphExpand(data + j * stride, first + i, n, bpp, palette, pixels);
+            for (int32_t k = 0; k < n; k++)
+            {
+                if (indices != NULL)
+                    putIndex(x + i + k, y + j, lookup(pixels[k]));
+                else
+                    buffer[(uint32_t)(y + j) * width + x + i + k] = pixels[k];
+            }
+        }
+    }
+
+    countPixels(w * h, 1);
+}
+
+void Graph_Raster::pushTo(Graph_Target *target, int32_t x, int32_t y, int32_t w, int32_t h) const
+{
+    int32_t left = x - originX;
+    int32_t top = y - originY;
+    if (indices != NULL)
+        target->pushIndexed(x, y, w, h, indices + (uint32_t)top * stride, left, stride, depth, palette);
+    else
+        target->pushImage(x, y, w, h, buffer + (uint32_t)top * width + left, width);
+}
+
+void Graph_Raster::setTextSize(uint8_t size)
+{
+    textSize = (size > 0) ? size : 1;
+}
+
+void Graph_Raster::setTextColor(uint16_t fg, uint16_t bg, bool bgfill)
+{
+    (void)bgfill;
+    textFG = fg;
+    textBG = bg;
+}
+
+void Graph_Raster::clear(uint16_t RGB565)
+{
+    if (indices != NULL)
+    {
+        uint8_t index = lookup(RGB565);
+        memset(indices, (depth == 8) ? index : index * 0x11, (size_t)stride * height);
+        return;
+    }
+
+    uint32_t n = (uint32_t)width * height;
+    for (uint32_t i = 0; i < n; i++)
+        buffer[i] = RGB565;
+}
+
+void Graph_Raster::scroll(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx)
+{
+    x -= originX;
+    y -= originY;
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (y + h > height)
+        h = height - y;
+    if (dx <= 0 || dx >= w || h <= 0)
+        return;
+
+    if (indices != NULL)
+    {
+        for (int32_t j = 0; j < h; j++)
+        {
+            if (depth == 8)
+            {
+                uint8_t *row = indices + (uint32_t)(y + j) * stride + x;
+                memmove(row, row + dx, w - dx);
+            }
+            else
+            {
+                for (int32_t i = 0; i < w - dx; i++)
+                    putIndex(x + i, y + j, getIndex(x + i + dx, y + j));
+            }
+        }
+        return;
+    }
+
+    for (int32_t j = 0; j < h; j++)
+    {
+        uint16_t *row = buffer + (uint32_t)(y + j) * width + x;
+        memmove(row, row + dx, (w - dx) * sizeof(uint16_t));
+    }
+}
+
+uint16_t Graph_Raster::readPixel(int32_t x, int32_t y) const
+{
+    x -= originX;
+    y -= originY;
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return 0;
+    if (indices != NULL)
+        return palette[getIndex(x, y)];
+    return buffer[(uint32_t)y * width + x];
+}
+
+bool Graph_Raster::writePPM(const char *path) const
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return false;
+
+    fprintf(f, "P6\n%u %u\n255\n", width, height);
+
+    uint8_t rgb[3];
+    uint32_t n = (uint32_t)width * height;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint16_t c = (indices != NULL) ? palette[getIndex(i % width, i / width)] : buffer[i];
+        rgb[0] = ((c >> 11) * 527 + 23) >> 6;
+        rgb[1] = (((c >> 5) & 0x3f) * 259 + 33) >> 6;
+        rgb[2] = ((c & 0x1f) * 527 + 23) >> 6;
+        fwrite(rgb, 1, 3, f);
+    }
+
+    return fclose(f) == 0;
+}
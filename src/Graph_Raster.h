@@ -0,0 +1,223 @@
+#pragma once
+#include "Graph_Target.h"
+
+#define GRAPH_INDEXED_BYTES(w, h, bpp) ((size_t)((w) * (bpp) + 7) / 8 * (h)) ///< Bytes of a palette indexed buffer.
+
+/**
+ * @class Graph_Raster
+ * @brief Software drawing target rasterizing into a RGB565 RAM buffer.
+ *
+ * The buffer is supplied by the caller (width * height uint16_t) and covers the screen area
+ * starting at (x, y), so a raster can hold a full screen or just one canvas. Everything outside of
+ * that area is clipped. The primitives follow the TFT_eSPI algorithms, so the pixels and the
+ * traffic counters match what the panel would receive.
+ *
+ * An indexed raster stores 4 or 8 bits palette indices instead of RGB565 pixels, dividing the
+ * memory by 4 or 2. Colours are added to the palette the first time they are drawn; once it is
+ * full, a new colour takes the closest entry.
+ */
+class Graph_Raster : public Graph_Target
+{
+private:
+    uint16_t *buffer;  ///< RGB565 pixels, row-major, width * height.
+    uint8_t *indices;  ///< Palette indices, row-major, stride bytes per row (NULL for a RGB565 raster).
+    uint8_t depth;     ///< Bits per pixel: 16 for RGB565, 4 or 8 for palette indices.
+    uint16_t stride;   ///< Bytes per row of indices.
+    uint16_t *palette; ///< RGB565 colour of every index.
+    uint16_t paletteSize; ///< Number of entries of the palette (16 or 256).
+    uint16_t paletteUsed; ///< Number of entries already assigned.
+    uint8_t lastIndex; ///< Index of the last colour looked up.
+    uint16_t width;    ///< Width of the buffer in px.
+    uint16_t height;   ///< Height of the buffer in px.
+    int32_t originX;   ///< Screen X-coordinate of the buffer first pixel.
+    int32_t originY;   ///< Screen Y-coordinate of the buffer first pixel.
+    uint8_t textSize;  ///< Font scale factor.
+    uint16_t textFG;   ///< Text colour.
+    uint16_t textBG;   ///< Text background colour (same as textFG for transparent text).
+
+    /**
+     * @brief Write an horizontal run of pixels, clipped to the buffer.
+     */
+    void span(int32_t x, int32_t y, int32_t w, uint16_t color);
+
+    /**
+     * @brief Write a vertical run of pixels, clipped to the buffer.
+     */
+    void vspan(int32_t x, int32_t y, int32_t h, uint16_t color);
+
+    /**
+     * @brief Write a rectangle of pixels as a single address window, clipped to the buffer.
+     */
+    void block(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+
+    /**
+     * @brief Get the palette index of a colour, adding it or taking the closest entry.
+     */
+    uint8_t lookup(uint16_t color);
+
+    /**
+     * @brief Write an horizontal run of indices, already clipped, in buffer coordinates.
+     */
+    void fillIndex(int32_t x, int32_t y, int32_t w, uint8_t index);
+
+    void putIndex(int32_t x, int32_t y, uint8_t index)
+    {
+        uint8_t *p = indices + (uint32_t)y * stride;
+        if (depth == 8)
+            p[x] = index;
+        else
+            p[x >> 1] = (x & 1) ? (p[x >> 1] & 0xf0) | index : (p[x >> 1] & 0x0f) | (index << 4);
+    }
+
+    uint8_t getIndex(int32_t x, int32_t y) const
+    {
+        const uint8_t *p = indices + (uint32_t)y * stride;
+        if (depth == 8)
+            return p[x];
+        return (x & 1) ? p[x >> 1] & 0x0f : p[x >> 1] >> 4;
+    }
+
+    /**
+     * @brief Draw one character of the built-in font.
+     * @return Width of the character in px.
+     */
+    int16_t drawChar(char c, int32_t x, int32_t y);
+
+    void circleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, uint16_t color);
+    void fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t corners, int32_t delta, uint16_t color);
+
+public:
+    /**
+     * @brief Constructor for the Graph_Raster class.
+     * @param buffer RGB565 buffer of width * height pixels (NULL for an empty raster).
+     * @param width Width of the buffer.
+     * @param height Height of the buffer.
+     * @param x Screen X-coordinate covered by the first pixel of the buffer (default is 0).
+     * @param y Screen Y-coordinate covered by the first pixel of the buffer (default is 0).
+     */
+    Graph_Raster(uint16_t *buffer = NULL, uint16_t width = 0, uint16_t height = 0, int32_t x = 0, int32_t y = 0);
+
+    /**
+     * @brief Constructor for a palette indexed Graph_Raster.
+     * @param buffer Buffer of GRAPH_INDEXED_BYTES(width, height, bpp) bytes.
+     * @param bpp Bits per pixel, 4 (16 colours) or 8 (256 colours).
+     * @param palette Storage for the 16 or 256 RGB565 colours of the palette, filled as colours are drawn.
+     * @param width Width of the buffer.
+     * @param height Height of the buffer.
+     * @param x Screen X-coordinate covered by the first pixel of the buffer (default is 0).
+     * @param y Screen Y-coordinate covered by the first pixel of the buffer (default is 0).
+     */
+    Graph_Raster(uint8_t *buffer, uint8_t bpp, uint16_t *palette, uint16_t width, uint16_t height, int32_t x = 0, int32_t y = 0);
+
+    void drawPixel(int32_t x, int32_t y, uint16_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color);
+    int16_t drawString(const char *string, int32_t x, int32_t y);
+    int16_t drawNumber(long value, int32_t x, int32_t y);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride = 0);
+    void pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                     uint8_t bpp, const uint16_t *palette);
+    void setTextSize(uint8_t size);
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false);
+
+    /**
+     * @brief Fill the whole buffer with a colour, without touching the counters.
+     * @param RGB565 The color in RGB565 format.
+     */
+    void clear(uint16_t RGB565);
+
+    /**
+     * @brief Shift the content of a rectangle to the left, without touching the counters.
+     *
+     * The dx columns uncovered on the right keep their previous content.
+     * @param x Screen X-coordinate of the rectangle.
+     * @param y Screen Y-coordinate of the rectangle.
+     * @param w Width of the rectangle.
+     * @param h Height of the rectangle.
+     * @param dx Number of columns to shift.
+     */
+    void scroll(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx);
+
+    /**
+     * @brief Read back a pixel.
+     * @param x Screen X-coordinate.
+     * @param y Screen Y-coordinate.
+     * @return The RGB565 colour, 0 outside of the buffer.
+     */
+    uint16_t readPixel(int32_t x, int32_t y) const;
+
+    /**
+     * @brief Dump the buffer as a binary PPM (P6) image.
+     * @param path Output file path.
+     * @return true on success.
+     */
+    bool writePPM(const char *path) const;
+
+    /**
+     * @brief Send a rectangle of the buffer to another target through a single address window.
+     *
+     * Palette indices are expanded to RGB565 on the way.
+     * @param target Target receiving the pixels.
+     * @param x Screen X-coordinate of the rectangle.
+     * @param y Screen Y-coordinate of the rectangle.
+     * @param w Width of the rectangle.
+     * @param h Height of the rectangle.
+     */
+    void pushTo(Graph_Target *target, int32_t x, int32_t y, int32_t w, int32_t h) const;
+
+    /**
+     * @brief Add a colour to the palette of an indexed raster, if not already there and if there is room.
+     * @param RGB565 The color in RGB565 format.
+     */
+    void addColor(uint16_t RGB565) { lookup(RGB565); }
+
+    /**
+     * @brief Forget the colours of the palette of an indexed raster, but the first ones.
+     *
+     * The pixels using a forgotten colour must be drawn again.
+     * @param keep Number of entries kept.
+     */
+    void resetPalette(uint16_t keep) { paletteUsed = (keep < paletteUsed) ? keep : paletteUsed; }
+
+    /**
+     * @brief Move the raster to another buffer of the same size, keeping its state and counters.
+     * @param buffer RGB565 buffer of width * height pixels.
+     */
+    void setBuffer(uint16_t *buffer) { this->buffer = buffer; }
+
+    /**
+     * @brief Move the raster over another area of the screen, keeping its buffer, state and counters.
+     * @param x Screen X-coordinate of the buffer first pixel.
+     * @param y Screen Y-coordinate of the buffer first pixel.
+     * @param height Height of the area, no more rows than the buffer holds.
+     */
+    void moveTo(int32_t x, int32_t y, uint16_t height)
+    {
+        originX = x;
+        originY = y;
+        this->height = height;
+    }
+
+    /**
+     * @brief Check whether the raster has no buffer to draw into.
+     */
+    bool isEmpty(void) const { return buffer == NULL && indices == NULL; }
+
+    uint16_t *getBuffer(void) { return buffer; }
+    const uint8_t *getIndices(void) const { return indices; }
+    const uint16_t *getPalette(void) const { return palette; }
+    uint16_t getPaletteUsed(void) const { return paletteUsed; }
+    uint8_t getDepth(void) const { return depth; }
+    uint16_t getWidth(void) const { return width; }
+    uint16_t getHeight(void) const { return height; }
+    int32_t getX(void) const { return originX; }
+    int32_t getY(void) const { return originY; }
+};
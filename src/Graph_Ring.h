@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class Graph_Ring
+ * @brief Fixed-capacity ring buffer over caller-supplied storage.
+ *
+ * Pushing into a full ring overwrites the oldest element. Every operation is O(1).
+ * @tparam T Type of the elements.
+ */
+template <typename T>
+class Graph_Ring
+{
+private:
+    T *buffer;         ///< Storage for capacity elements.
+    uint16_t capacity; ///< Maximum number of elements.
+    uint16_t head;     ///< Index of the next write.
+    uint16_t count;    ///< Number of elements held.
+
+public:
+    /**
+     * @brief Constructor for the Graph_Ring class.
+     * @param buffer Storage for capacity elements (NULL for an empty ring).
+     * @param capacity Maximum number of elements.
+     */
+    Graph_Ring(T *buffer = NULL, uint16_t capacity = 0) : buffer(buffer), capacity(capacity), head(0), count(0) {}
+
+    /**
+     * @brief Append an element, dropping the oldest one if the ring is full.
+     * @param value Element to append.
+     */
+    void push(T value)
+    {
+        if (capacity == 0)
+            return;
+        buffer[head] = value;
+        head = (head + 1 == capacity) ? 0 : head + 1;
+        if (count < capacity)
+            count++;
+    }
+
+    /**
+     * @brief Get an element.
+     * @param i Index of the element, 0 being the oldest one.
+     */
+    T operator[](uint16_t i) const
+    {
+        uint32_t idx = (uint32_t)head + capacity - count + i;
+        return buffer[(idx >= capacity) ? idx - capacity : idx];
+    }
+
+    /**
+     * @brief Remove every element.
+     */
+    void clear(void)
+    {
+        head = 0;
+        count = 0;
+    }
+
+    uint16_t size(void) const { return count; }
+    uint16_t getCapacity(void) const { return capacity; }
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <stdint.h>
+#include <type_traits>
+
+/**
+ * @struct Graph_Type
+ * @brief Identity type, used to stop a parameter from taking part in template deduction.
+ *
+ * The limits of setDataBARS(y_data, n, 0, 8) follow the type of y_data, whatever the type of the literals.
+ */
+template <typename T>
+struct Graph_Type
+{
+    typedef T type;
+};
+
+/**
+ * @brief Compute d * px / range, rounded down, for d up to range, without overflowing 64 bits.
+ *
+ * The product is exact below a range of 2^48. Above, the quotient is built one bit of px at a
+ * time, the remainder staying below range (16 steps).
+ */
+inline uint32_t graphMulDiv(uint64_t d, uint16_t px, uint64_t range)
+{
+    if ((range >> 48) == 0)
+        return d * px / range;
+
+    uint32_t q = 0;
+    uint64_t rem = 0;
+    for (int8_t b = 15; b >= 0; b--)
+    {
+        // (q, rem) = 2 * (q, rem), then + d if the bit is set, each sum reduced modulo range
+        q <<= 1;
+        if (rem >= range - rem)
+        {
+            rem -= range - rem;
+            q++;
+        }
+        else
+        {
+            rem += rem;
+        }
+        if ((px >> b) & 1)
+        {
+            if (rem >= range - d)
+            {
+                rem -= range - d;
+                q++;
+            }
+            else
+            {
+                rem += d;
+            }
+        }
+    }
+    return q;
+}
+
+/**
+ * @struct Graph_Scale
+ * @brief Maps a sample of type T from a [min, max] range to [0, px] pixels.
+ *
+ * Integer samples are scaled with integer arithmetic only: on 32 bits up to 16 bits samples, on
+ * 64 bits for 32 bits samples, and with graphMulDiv for 64 bits samples, whose range times px
+ * doesn't fit in 64 bits. Floating point samples use their own type.
+ */
+template <typename T, bool INTEGRAL = std::is_integral<T>::value>
+struct Graph_Scale
+{
+    typedef typename std::conditional<(sizeof(T) <= 2), uint32_t, uint64_t>::type wide;
+
+    /**
+     * @brief Scale a value, clamped to the range.
+     * @param v Value to scale.
+     * @param min Value mapped to 0.
+     * @param max Value mapped to px.
+     * @param px Length of the range in px.
+     * @return Position of the value in px, 0 for an empty range.
+     */
+    static int32_t map(T v, T min, T max, uint16_t px)
+    {
+        if (!(max > min))
+            return 0;
+        v = (v < min) ? min : v;
+        v = (v > max) ? max : v;
+        // Differences are computed on the wide unsigned type, exact for signed samples too
+        wide d = (wide)v - (wide)min;
+        wide range = (wide)max - (wide)min;
+        if (sizeof(T) == 8)
+            return graphMulDiv(d, px, range);
+        return d * px / range;
+    }
+};
+
+template <typename T>
+struct Graph_Scale<T, false>
+{
+    static int32_t map(T v, T min, T max, uint16_t px)
+    {
+        if (!(max > min))
+            return 0;
+        // NaN samples fall to the bottom of the range
+        v = (v >= min) ? v : min;
+        v = (v > max) ? max : v;
+        return (int32_t)((v - min) * px / (max - min));
+    }
+};
+
+/**
+ * @brief Check whether an array is in ascending order.
+ * @param data Array to check.
+ * @param n Number of elements.
+ */
+template <typename T>
+bool graphIsSorted(const T *data, uint32_t n)
+{
+    for (uint32_t i = 1; i < n; i++)
+    {
+        if (data[i] < data[i - 1])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Find the next element of an array in (value, index) order, without sorting it.
+ * @param data Array to walk.
+ * @param n Number of elements.
+ * @param prev Index of the current element, n to get the first one.
+ * @return Index of the next element, n after the last one.
+ */
+template <typename T>
+uint32_t graphNextInOrder(const T *data, uint32_t n, uint32_t prev)
+{
+    uint32_t next = n;
+    for (uint32_t j = 0; j < n; j++)
+    {
+        // Skip the elements up to prev, equal values being ordered by index
+        if (prev < n && (data[j] < data[prev] || (!(data[prev] < data[j]) && j <= prev)))
+            continue;
+        if (next == n || data[j] < data[next])
+            next = j;
+    }
+    return next;
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include "Graph_Target.h"
+
+/* Render statistics, compiled out unless built with -DGRAPH_ENABLE_STATS=1 */
+#ifndef GRAPH_ENABLE_STATS
+#define GRAPH_ENABLE_STATS 0
+#endif
+
+/**
+ * @enum GRAPH_PHASE
+ * @brief Phases of a render, every drawing call of a frame is accounted to one of them.
+ */
+typedef enum
+{
+    PHASE_BACKGROUND, ///< Background of the canvas.
+    PHASE_AXIS,       ///< Frame and axis lines.
+    PHASE_TITLE,      ///< Title of the graph.
+    PHASE_DATA,       ///< Bars, lines, slices, samples (anything not in another phase).
+    PHASE_LABELS,     ///< Axis and slice labels.
+    PHASE_PUSH,       ///< Framebuffer blocks pushed to the panel.
+    GRAPH_PHASES      ///< Number of phases.
+} GRAPH_PHASE;
+
+/**
+ * @struct GRAPH_PHASE_STATS
+ * @brief Cost of a phase or of a whole frame.
+ */
+struct GRAPH_PHASE_STATS
+{
+    uint32_t us;         ///< Elapsed time in microseconds.
+    uint32_t primitives; ///< Number of drawing calls.
+    uint32_t pixels;     ///< Number of pixels written.
+    uint32_t bytes;      ///< Bytes that would go over SPI.
+};
+
+/**
+ * @struct GRAPH_STATS
+ * @brief Render statistics of a Graph_TFT.
+ *
+ * In framebuffer mode the drawing phases count the writes to the framebuffer, and PHASE_PUSH the
+ * traffic actually sent to the panel.
+ */
+struct GRAPH_STATS
+{
+    GRAPH_PHASE_STATS phase[GRAPH_PHASES]; ///< Cost of each phase in the last frame.
+    GRAPH_PHASE_STATS last;                ///< Total cost of the last frame.
+    GRAPH_PHASE_STATS min;                 ///< Lowest total cost of a frame, field by field.
+    GRAPH_PHASE_STATS avg;                 ///< Average total cost of a frame.
+    GRAPH_PHASE_STATS max;                 ///< Highest total cost of a frame, field by field.
+    uint32_t frames;                       ///< Number of frames since the last reset.
+};
+
+#if defined(ESP_PLATFORM)
+#include <esp_timer.h>
+#elif defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief Monotonic time in microseconds, wrapping around every 71 minutes.
+ */
+static inline uint32_t graphMicros(void)
+{
+#if defined(ESP_PLATFORM)
+    return (uint32_t)esp_timer_get_time();
+#elif defined(ARDUINO)
+    return micros();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#if GRAPH_ENABLE_STATS
+
+/**
+ * @class Graph_Stats
+ * @brief Accounts the time and the traffic of a frame to its phases.
+ *
+ * One phase is active at a time: entering a phase charges everything since the previous switch to
+ * the phase being left. Calls outside of a frame are ignored.
+ */
+class Graph_Stats
+{
+private:
+    GRAPH_STATS stats;     ///< Statistics reported.
+    uint64_t sum[4];       ///< Sums of the frame totals, for the averages.
+    Graph_Target *target1; ///< Drawing target of the frame.
+    Graph_Target *target2; ///< Output target, if different from target1.
+    GRAPH_PHASE current;   ///< Active phase.
+    bool running;          ///< Whether a frame is being accounted.
+    uint32_t mark;         ///< Time of the last switch.
+    GRAPH_COUNTERS marked; ///< Sum of the counters of the targets at the last switch.
+
+    GRAPH_COUNTERS read(void) const
+    {
+        GRAPH_COUNTERS c = target1->getCounters();
+        if (target2 != NULL && target2 != target1)
+        {
+            c.primitives += target2->getCounters().primitives;
+            c.pixels += target2->getCounters().pixels;
+            c.bytes += target2->getCounters().bytes;
+        }
+        return c;
+    }
+
+    void charge(void)
+    {
+        uint32_t now = graphMicros();
+        GRAPH_COUNTERS c = read();
+        GRAPH_PHASE_STATS &p = stats.phase[current];
+        p.us += now - mark;
+        p.primitives += c.primitives - marked.primitives;
+        p.pixels += c.pixels - marked.pixels;
+        p.bytes += c.bytes - marked.bytes;
+        mark = now;
+        marked = c;
+    }
+
+public:
+    Graph_Stats(void) : target1(NULL), target2(NULL), current(PHASE_DATA), running(false) { reset(); }
+
+    /**
+     * @brief Start accounting a frame, in PHASE_DATA.
+     * @param target Drawing target of the frame.
+     * @param output Target the frame is pushed to (same as target in direct mode).
+     */
+    void beginFrame(Graph_Target *target, Graph_Target *output)
+    {
+        for (uint8_t i = 0; i < GRAPH_PHASES; i++)
+        {
+            stats.phase[i] = GRAPH_PHASE_STATS();
+        }
+        target1 = target;
+        target2 = output;
+        current = PHASE_DATA;
+        running = true;
+        mark = graphMicros();
+        marked = read();
+    }
+
+    /**
+     * @brief Switch to another phase.
+     * @param phase Phase to enter.
+     * @return The phase left.
+     */
+    GRAPH_PHASE enter(GRAPH_PHASE phase)
+    {
+        GRAPH_PHASE previous = current;
+        if (running && phase != current)
+        {
+            charge();
+            current = phase;
+        }
+        return previous;
+    }
+
+    /**
+     * @brief End the frame and update the totals.
+     */
+    void endFrame(void)
+    {
+        if (!running)
+            return;
+        charge();
+        running = false;
+
+        GRAPH_PHASE_STATS t = GRAPH_PHASE_STATS();
+        for (uint8_t i = 0; i < GRAPH_PHASES; i++)
+        {
+            t.us += stats.phase[i].us;
+            t.primitives += stats.phase[i].primitives;
+            t.pixels += stats.phase[i].pixels;
+            t.bytes += stats.phase[i].bytes;
+        }
+
+        stats.last = t;
+        if (stats.frames == 0)
+        {
+            stats.min = t;
+            stats.max = t;
+        }
+        stats.min.us = (t.us < stats.min.us) ? t.us : stats.min.us;
+        stats.min.primitives = (t.primitives < stats.min.primitives) ? t.primitives : stats.min.primitives;
+        stats.min.pixels = (t.pixels < stats.min.pixels) ? t.pixels : stats.min.pixels;
+        stats.min.bytes = (t.bytes < stats.min.bytes) ? t.bytes : stats.min.bytes;
+        stats.max.us = (t.us > stats.max.us) ? t.us : stats.max.us;
+        stats.max.primitives = (t.primitives > stats.max.primitives) ? t.primitives : stats.max.primitives;
+        stats.max.pixels = (t.pixels > stats.max.pixels) ? t.pixels : stats.max.pixels;
+        stats.max.bytes = (t.bytes > stats.max.bytes) ? t.bytes : stats.max.bytes;
+
+        stats.frames++;
+        sum[0] += t.us;
+        sum[1] += t.primitives;
+        sum[2] += t.pixels;
+        sum[3] += t.bytes;
+        stats.avg.us = sum[0] / stats.frames;
+        stats.avg.primitives = sum[1] / stats.frames;
+        stats.avg.pixels = sum[2] / stats.frames;
+        stats.avg.bytes = sum[3] / stats.frames;
+    }
+
+    /**
+     * @brief Clear every statistic.
+     */
+    void reset(void)
+    {
+        stats = GRAPH_STATS();
+        sum[0] = sum[1] = sum[2] = sum[3] = 0;
+    }
+
+    const GRAPH_STATS &get(void) const { return stats; }
+};
+
+/**
+ * @brief Accounts the rest of the enclosing scope to a phase, then goes back to the previous one.
+ */
+class Graph_PhaseScope
+{
+private:
+    Graph_Stats &stats;
+    GRAPH_PHASE previous;
+
+public:
+    Graph_PhaseScope(Graph_Stats &stats, GRAPH_PHASE phase) : stats(stats) { previous = stats.enter(phase); }
+    ~Graph_PhaseScope() { stats.enter(previous); }
+};
+
+#define GRAPH_PHASE_SCOPE(phase) Graph_PhaseScope graphPhaseScope(stats, phase)
+#else
+#define GRAPH_PHASE_SCOPE(phase)
+#endif
@@ -1,36 +1,587 @@
 #include "Graph_TFT.h"
+#include "Graph_Trig.h"
+#include <string.h>
+#include <math.h>
+
+static const uint16_t defaultPalette[] = {0x08aa, 0x1ad5, 0xa236, 0xf334, 0xfd36};
+static const uint16_t seriesPalette[] = {0xfd20, 0x07ff, 0xf81f, 0x87e0, 0xffe0}; // Series after the first one, bright on every style
+
+/* Scatter markers: first column from the centre and width of the rows -2 to 2, by GRAPH_MARKER */
+static const int8_t stamps[4][5][2] = {
+    {{0, 0}, {0, 0}, {0, 1}, {0, 0}, {0, 0}},
+    {{0, 0}, {0, 1}, {-1, 3}, {0, 1}, {0, 0}},
+    {{0, 0}, {-1, 3}, {-1, 3}, {-1, 3}, {0, 0}},
+    {{-1, 3}, {-2, 5}, {-2, 5}, {-2, 5}, {-1, 3}},
+};
+
+static int32_t isqrt(int32_t n)
+{
+    int32_t root = 0;
+    int32_t bit = 1L << 30;
+    while (bit > n)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Walks the slices crossed by one half of a pie scanline, from the center outwards.
+ *
+ * Along a half row the angle is monotonic and spans less than a quarter turn, so the slices are
+ * met in order and each boundary is crossed at most once: x = -dy * sin(a) / cos(a).
+ */
+template <typename T>
+struct PieWalker
+{
+    const T *values;
+    uint8_t n_data;
+    uint32_t total;
+    int32_t dy;        ///< Row offset from the center.
+    int32_t w;         ///< Half width of the row.
+    int32_t pos;       ///< Distance from the center of the first px not walked yet.
+    bool forward;      ///< Whether the angle increases moving outwards.
+    uint16_t origin;   ///< Angle at the center end of the half row.
+    uint8_t slice;     ///< Current slice.
+    uint32_t cumStart; ///< Sum of the values before the current slice.
+    uint16_t wrap;     ///< GRAPH_ANGLE_FULL once the walk went across angle 0.
+
+    uint16_t angle(uint32_t cum) const
+    {
+        return (uint64_t)cum * GRAPH_ANGLE_FULL / total;
+    }
+
+    PieWalker(const T *values, uint8_t n_data, uint32_t total, int32_t dy, int32_t w, int8_t side)
+        : values(values), n_data(n_data), total(total), dy(dy), w(w), wrap(0)
+    {
+        // Right half above the center goes from 12 to 3 o'clock, left half from 12 to 9, etc.
+        pos = (side > 0) ? 0 : 1;
+        if (dy < 0)
+        {
+            forward = (side > 0);
+            origin = (side > 0) ? 0 : GRAPH_ANGLE_FULL;
+        }
+        else if (dy > 0)
+        {
+            forward = (side < 0);
+            origin = GRAPH_ANGLE_FULL / 2;
+        }
+        else
+        {
+            forward = true;
+            origin = (side > 0) ? GRAPH_ANGLE_FULL / 4 : 3 * GRAPH_ANGLE_FULL / 4;
+        }
+
+        // Slice containing the angle just after the origin, in the walking direction
+        uint32_t cum = 0;
+        for (slice = 0; slice < n_data - 1; slice++)
+        {
+            uint16_t a0 = angle(cum);
+            uint16_t a1 = angle(cum + values[slice]);
+            if (forward ? (a0 <= origin && origin < a1) : (a0 < origin && origin <= a1))
+                break;
+            cum += values[slice];
+        }
+        cumStart = cum;
+    }
+
+    /**
+     * @brief Get the next non-empty span, as distances from the center.
+     * @return false once the half row is complete.
+     */
+    bool next(int32_t &from, int32_t &to, uint8_t &s)
+    {
+        while (pos <= w)
+        {
+            s = slice;
+            from = pos;
+            to = w;
+
+            // Boundary ahead, valid while it is less than a quarter turn away from the origin
+            uint16_t a = forward ? angle(cumStart + values[slice]) : angle(cumStart);
+            int32_t distance = forward ? (int32_t)a + wrap - origin : (int32_t)origin - a + wrap;
+            if (dy != 0 && distance < GRAPH_ANGLE_FULL / 4)
+            {
+                int32_t x = -dy * graphSin(a) / graphCos(a);
+                x = (x < 0) ? -x : x;
+                if (x <= w)
+                {
+                    to = (x - 1 < pos - 1) ? pos - 1 : x - 1;
+                    advance();
+                }
+            }
+
+            pos = to + 1;
+            if (to >= from)
+                return true;
+        }
+        return false;
+    }
+
+    void advance(void)
+    {
+        if (forward)
+        {
+            cumStart += values[slice];
+            if (++slice == n_data)
+            {
+                slice = 0;
+                cumStart = 0;
+                wrap = GRAPH_ANGLE_FULL;
+            }
+        }
+        else
+        {
+            if (slice == 0)
+            {
+                slice = n_data;
+                cumStart = total;
+                wrap = GRAPH_ANGLE_FULL;
+            }
+            cumStart -= values[--slice];
+        }
+    }
+};
+
 
-Graph_TFT::Graph_TFT(TFT_eSPI *display, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t padding, uint8_t rounded, GRAPH_STYLE style)
+Graph_TFT::Graph_TFT(Graph_Target *target, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t padding, uint8_t rounded, GRAPH_STYLE style)
 {
-    tft = display;
-    canva_style.canvasWidth = width;
-    canva_style.canvasHeight = height;
-    canva_style.x = x;
-    canva_style.y = y;
-    canva_style.padding = padding;
-    canva_style.rounded = rounded;
+    panel = target;
+    tft = panel;
+    title = NULL;
+    canva_style = makeCanva(x, y, width, height, padding, rounded);
     setCanva(style);
 }
 
-Graph_TFT::Graph_TFT(TFT_eSPI *display, CANVA_STYLE canva_style, GRAPH_STYLE style)
+Graph_TFT::Graph_TFT(Graph_Target *target, CANVA_STYLE canva_style, GRAPH_STYLE style)
 {
-    tft = display;
+    panel = target;
+    tft = panel;
+    title = NULL;
     this->canva_style = canva_style;
     setCanva(style);
 }
 
+#ifdef ARDUINO
+Graph_TFT::Graph_TFT(TFT_eSPI *display, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t padding, uint8_t rounded, GRAPH_STYLE style) : espi(display)
+{
+    panel = &espi;
+    tft = panel;
+    title = NULL;
+    canva_style = makeCanva(x, y, width, height, padding, rounded);
+    setCanva(style);
+}
+
+Graph_TFT::Graph_TFT(TFT_eSPI *display, CANVA_STYLE canva_style, GRAPH_STYLE style) : espi(display)
+{
+    panel = &espi;
+    tft = panel;
+    title = NULL;
+    this->canva_style = canva_style;
+    setCanva(style);
+}
+#endif
+
+CANVA_STYLE Graph_TFT::makeCanva(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t padding, uint8_t rounded)
+{
+    CANVA_STYLE canva;
+    canva.canvasWidth = width;
+    canva.canvasHeight = height;
+    canva.x = x;
+    canva.y = y;
+    canva.padding = padding;
+    canva.rounded = rounded;
+    return canva;
+}
+
+void Graph_TFT::beginFrame(void)
+{
+    axisHeld = false;
+#if GRAPH_ENABLE_STATS
+    stats.beginFrame(listing() ? &lists[shown ^ 1] : striping() ? &strip : (!frame.isEmpty() ? &frame : panel), panel);
+#endif
+    if (listing())
+    {
+        lists[shown ^ 1].clear();
+        tft = &lists[shown ^ 1];
+        fullFrame = true;
+        tft->setTextSize(TEXT_SIZE);
+        tft->setTextColor(canva_style.draw1, canva_style.background, false);
+        return;
+    }
+    if (striping())
+    {
+        // The graph is drawn strip by strip at endFrame
+        strip.moveTo(canva_style.x, canva_style.y, stripRows);
+        tft = &strip;
+        fullFrame = true;
+        tft->setTextSize(TEXT_SIZE);
+        tft->setTextColor(canva_style.draw1, canva_style.background, false);
+        return;
+    }
+    if (frame.isEmpty())
+        return;
+
+    if (presented)
+    {
+        // The buffer being sent stays untouched, the frame is drawn over a copy of it
+        uint16_t *sent = frame.getBuffer();
+        memcpy(spare, sent, (size_t)frame.getWidth() * frame.getHeight() * sizeof(uint16_t));
+        frame.setBuffer(spare);
+        spare = sent;
+        presented = false;
+    }
+    dirtyTop = frame.getHeight();
+    dirtyBottom = 0;
+
+    tft = &frame;
+    fullFrame = true;
+    tft->setTextSize(TEXT_SIZE);
+    tft->setTextColor(canva_style.draw1, canva_style.background, false);
+}
+
+void Graph_TFT::endFrame(void)
+{
+    if (listing() && tft == &lists[shown ^ 1])
+    {
+        // The setters leave the drawing to endFrame, the whole graph is recorded once
+        invalidate();
+        drawScene(true);
+        flushList();
+        tft = panel;
+    }
+    else if (striping() && tft == &strip)
+    {
+        drawStrips();
+        tft = panel;
+    }
+    else if (tft == &frame)
+    {
+        GRAPH_PHASE_SCOPE(PHASE_PUSH);
+        if (spare != NULL)
+        {
+            // Send the band of changed rows, contiguous in the framebuffer
+            if (fullFrame)
+            {
+                dirtyTop = 0;
+                dirtyBottom = frame.getHeight();
+            }
+            if (dirtyBottom > dirtyTop)
+            {
+                panel->pushImageAsync(frame.getX(), frame.getY() + dirtyTop, frame.getWidth(), dirtyBottom - dirtyTop,
+                                      frame.getBuffer() + dirtyTop * frame.getWidth());
+                presented = true;
+            }
+        }
+        else if (fullFrame)
+        {
+            frame.pushTo(panel, frame.getX(), frame.getY(), frame.getWidth(), frame.getHeight());
+        }
+        tft = panel;
+    }
+#if GRAPH_ENABLE_STATS
+    stats.endFrame();
+#endif
+}
+
+void Graph_TFT::pushRect(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    if (tft != &frame)
+        return;
+
+    if (spare != NULL)
+    {
+        int32_t top = y - frame.getY();
+        dirtyTop = (top < dirtyTop) ? ((top > 0) ? top : 0) : dirtyTop;
+        dirtyBottom = (top + h > dirtyBottom) ? ((top + h < frame.getHeight()) ? top + h : frame.getHeight()) : dirtyBottom;
+        return;
+    }
+
+    GRAPH_PHASE_SCOPE(PHASE_PUSH);
+    frame.pushTo(panel, x, y, w, h);
+}
+
+void Graph_TFT::flushList(void)
+{
+    Graph_List &list = lists[shown ^ 1];
+    if (list.isOverflowed())
+    {
+        // Too many calls to keep, the frame is drawn directly like without a list
+        listValid = false;
+        tft = panel;
+        tft->setTextSize(TEXT_SIZE);
+        tft->setTextColor(canva_style.draw1, canva_style.background, false);
+        invalidate();
+        drawScene(true);
+        return;
+    }
+
+    GRAPH_PHASE_SCOPE(PHASE_PUSH);
+    GRAPH_RECT rects[GRAPH_LIST_RECTS];
+    uint8_t n = 1;
+    if (listValid)
+    {
+        n = list.diff(lists[shown], rects, GRAPH_LIST_RECTS, scratch);
+    }
+    else
+    {
+        rects[0].left = canva_style.x;
+        rects[0].top = canva_style.y;
+        rects[0].right = canva_style.x + canva_style.canvasWidth - 1;
+        rects[0].bottom = canva_style.y + canva_style.canvasHeight - 1;
+    }
+
+    listValid = true;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if (!drawBands(list, rects[i]))
+        {
+            // No room to rasterize, the whole frame goes to the panel
+            list.replay(panel);
+            break;
+        }
+    }
+    shown ^= 1;
+}
+
+void Graph_TFT::drawStrips(void)
+{
+    int32_t bottom = canva_style.y + canva_style.canvasHeight;
+    for (int32_t y = canva_style.y; y < bottom; y += stripRows)
+    {
+        uint16_t h = (bottom - y < stripRows) ? bottom - y : stripRows;
+        strip.moveTo(canva_style.x, y, h);
+        strip.clear(screen);
+        strip.setTextSize(TEXT_SIZE);
+        strip.setTextColor(canva_style.draw1, canva_style.background, false);
+        invalidate();
+        drawScene(true);
+
+        GRAPH_PHASE_SCOPE(PHASE_PUSH);
+        panel->pushImage(canva_style.x, y, canva_style.canvasWidth, h, strip.getBuffer());
+    }
+}
+
+bool Graph_TFT::drawBands(const Graph_List &list, GRAPH_RECT area)
+{
+    // Nothing is drawn outside of the canvas
+    int32_t left = (area.left > canva_style.x) ? area.left : canva_style.x;
+    int32_t top = (area.top > canva_style.y) ? area.top : canva_style.y;
+    int32_t right = (area.right < canva_style.x + canva_style.canvasWidth - 1) ? area.right : canva_style.x + canva_style.canvasWidth - 1;
+    int32_t bottom = (area.bottom < canva_style.y + canva_style.canvasHeight - 1) ? area.bottom : canva_style.y + canva_style.canvasHeight - 1;
+    if (right < left || bottom < top)
+        return true;
+
+    int32_t w = right - left + 1;
+    size_t room = striping() ? (size_t)canva_style.canvasWidth * stripRows * sizeof(uint16_t) + alignof(uint16_t)
+                             : scratch.getSize() - scratch.getUsed();
+    int32_t rows = (room > alignof(uint16_t)) ? (room - alignof(uint16_t)) / (w * sizeof(uint16_t)) : 0;
+    rows = (rows < bottom - top + 1) ? rows : bottom - top + 1;
+    if (rows < 1)
+        return false;
+
+    size_t mark = scratch.mark();
+    uint16_t *pixels = striping() ? strip.getBuffer() : scratch.alloc<uint16_t>(w * rows);
+    if (pixels == NULL)
+        return false;
+
+    for (int32_t y = top; y <= bottom; y += rows)
+    {
+        int32_t h = (bottom - y + 1 < rows) ? bottom - y + 1 : rows;
+        Graph_Raster band(pixels, w, h, left, y);
+        band.clear(screen);
+        GRAPH_RECT clip = {(int16_t)left, (int16_t)y, (int16_t)right, (int16_t)(y + h - 1)};
+        list.replay(&band, clip);
+        panel->pushImage(left, y, w, h, pixels);
+    }
+    scratch.release(mark);
+    return true;
+}
+
+void Graph_TFT::invalidate(void)
+{
+    barCount = 0;
+    streamDrawn = false;
+    heatDrawn = false;
+}
+
+void Graph_TFT::setFramebuffer(uint16_t *buffer, uint16_t RGB565)
+{
+    panel->wait();
+    spare = NULL;
+    presented = false;
+    dirtyStatic = true;
+    invalidate();
+    frame = Graph_Raster(buffer, canva_style.canvasWidth, canva_style.canvasHeight, canva_style.x, canva_style.y);
+    if (buffer != NULL)
+    {
+        frame.clear(RGB565);
+    }
+}
+
+void Graph_TFT::setIndexedFramebuffer(uint8_t *buffer, uint8_t bpp, uint16_t *palette, uint16_t RGB565)
+{
+    setFramebuffer(NULL, RGB565);
+    if (buffer == NULL || palette == NULL)
+        return;
+
+    frame = Graph_Raster(buffer, bpp, palette, canva_style.canvasWidth, canva_style.canvasHeight, canva_style.x, canva_style.y);
+    frame.clear(RGB565);
+    mapPalette();
+}
+
+void Graph_TFT::mapPalette(void)
+{
+    if (frame.getIndices() == NULL)
+        return;
+
+    // Entry 0 keeps the screen colour of the corners, every other pixel is drawn again by the frame
+    frame.resetPalette(1);
+    frame.addColor(canva_style.background);
+    frame.addColor(canva_style.draw1);
+    frame.addColor(canva_style.draw2);
+    const uint16_t *colors = (palette != NULL) ? palette : defaultPalette;
+    uint8_t n_colors = (palette != NULL) ? paletteSize : sizeof(defaultPalette) / sizeof(defaultPalette[0]);
+    for (uint8_t i = 0; i < n_colors; i++)
+    {
+        frame.addColor(colors[i]);
+    }
+    if (palette == NULL)
+    {
+        for (uint8_t i = 0; i < sizeof(seriesPalette) / sizeof(seriesPalette[0]); i++)
+        {
+            frame.addColor(seriesPalette[i]);
+        }
+    }
+}
+
+void Graph_TFT::setDisplayList(GRAPH_COMMAND *commands, uint16_t capacity, uint16_t RGB565)
+{
+    setFramebuffer(NULL, RGB565);
+    lists[0] = Graph_List(commands, capacity);
+    lists[1] = Graph_List((commands != NULL) ? commands + capacity : NULL, capacity);
+    shown = 0;
+    listValid = false;
+    screen = RGB565;
+}
+
+void Graph_TFT::setStripBuffer(uint16_t *buffer, uint16_t rows, uint16_t RGB565)
+{
+    setFramebuffer(NULL, RGB565);
+    rows = (rows < canva_style.canvasHeight) ? rows : canva_style.canvasHeight;
+    stripRows = (buffer != NULL) ? rows : 0;
+    strip = Graph_Raster(buffer, canva_style.canvasWidth, stripRows, canva_style.x, canva_style.y);
+    screen = RGB565;
+}
+
+void Graph_TFT::setAsyncFramebuffers(uint16_t *buffer, uint16_t *second, uint16_t RGB565, uint16_t *bounce)
+{
+    setFramebuffer(buffer, RGB565);
+    if (buffer != NULL)
+    {
+        spare = second;
+    }
+#ifdef ARDUINO
+    if (panel == &espi)
+    {
+        espi.setDMABuffer(bounce, (uint32_t)canva_style.canvasWidth * canva_style.canvasHeight);
+    }
+#else
+    (void)bounce;
+#endif
+}
+
+void Graph_TFT::setStaticLayer(uint16_t *buffer, uint16_t RGB565)
+{
+    layer = Graph_Raster(buffer, canva_style.canvasWidth, canva_style.canvasHeight, canva_style.x, canva_style.y);
+    layerValid = false;
+    dirtyStatic = true;
+    if (buffer != NULL)
+    {
+        layer.clear(RGB565);
+    }
+}
+
+void Graph_TFT::drawStatic(bool axis, const GRAPH_LABELS *labels)
+{
+    labelsDrawn = false;
+    if (tft == &frame)
+    {
+        mapPalette();
+    }
+    if (layer.getBuffer() == NULL)
+    {
+        drawBackground();
+        if (axis)
+        {
+            drawAxis();
+        }
+        drawTitle();
+        return;
+    }
+
+    bool sameLabels = (labels == NULL) ? !layerLabels
+                                       : layerLabels && labels->deltaX_px == labelsKey.deltaX_px &&
+                                             labels->min_Y == labelsKey.min_Y && labels->max_Y == labelsKey.max_Y &&
+                                             labels->min_X == labelsKey.min_X && labels->max_X == labelsKey.max_X &&
+                                             labels->stepY == labelsKey.stepY;
+
+    if (!layerValid || layerAxis != axis || !sameLabels)
+    {
+        Graph_Target *target = tft;
+        tft = &layer;
+        tft->setTextSize(TEXT_SIZE);
+        tft->setTextColor(canva_style.draw1, canva_style.background, false);
+        drawBackground();
+        if (axis)
+        {
+            drawAxis();
+        }
+        drawTitle();
+        if (labels != NULL)
+        {
+            drawLabels(*labels);
+            labelsKey = *labels;
+        }
+        tft = target;
+        layerValid = true;
+        layerAxis = axis;
+        layerLabels = (labels != NULL);
+    }
+
+    GRAPH_PHASE_SCOPE(PHASE_BACKGROUND);
+    tft->pushImage(layer.getX(), layer.getY(), layer.getWidth(), layer.getHeight(), layer.getBuffer());
+    labelsDrawn = (labels != NULL);
+}
+
 void Graph_TFT::drawTitle()
 {
+    if (title == NULL)
+        return;
+    GRAPH_PHASE_SCOPE(PHASE_TITLE);
     tft->drawString(title, canva_style.x + canva_style.padding * 2, canva_style.y + canva_style.padding / 2);
 }
 
 void Graph_TFT::drawBackground(void)
 {
+    GRAPH_PHASE_SCOPE(PHASE_BACKGROUND);
     tft->fillRoundRect(canva_style.x, canva_style.y, canva_style.canvasWidth, canva_style.canvasHeight, canva_style.rounded, canva_style.background);
 }
 
 void Graph_TFT::drawAxis(void)
 {
+    GRAPH_PHASE_SCOPE(PHASE_AXIS);
     if (!canva_style.fill)
     {
         tft->drawRoundRect(canva_style.x, canva_style.y, canva_style.canvasWidth, canva_style.canvasHeight, canva_style.rounded, canva_style.draw1);
@@ -39,100 +590,365 @@ void Graph_TFT::drawAxis(void)
     tft->drawLine(startX, startY, endX, startY, canva_style.draw1);
 }
 
-void Graph_TFT::drawBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y)
+void Graph_TFT::setStream(uint16_t *buffer, uint16_t capacity, uint16_t min_Y, uint16_t max_Y)
 {
-    drawBackground();
-    drawAxis();
-    drawTitle();
+    stream = Graph_Ring<uint16_t>(buffer, capacity);
+    streamTotal = 0;
+    // An empty range keeps one unit, lowering the minimum so that the maximum can't wrap
+    streamMinY = (max_Y > min_Y) ? min_Y : (min_Y < 0xFFFF) ? min_Y : 0xFFFE;
+    streamMaxY = (max_Y > min_Y) ? max_Y : streamMinY + 1;
+    streamWindow = NULL;
+    heat = Graph_Heatmap();
+    axisValid = false;
+    labelStepY = 0;
+    data.draw = NULL;
+    pendingSamples = 0;
+    if (retained)
+    {
+        dirtyStatic = true;
+        return;
+    }
 
-    float deltaX_px = (graphW - (n_data + 1)) / n_data;
-    float deltaY_px = graphH / (max_Y - min_Y);
+    beginFrame();
+    if (!deferred())
+    {
+        drawStream();
+    }
+    endFrame();
+}
 
-    uint16_t x = 2 + startX;
-    uint16_t barHeight = 0;
-    for (uint8_t i = 0; i < n_data; i++)
+void Graph_TFT::setStream(uint16_t *buffer, uint16_t capacity, Graph_Window<uint16_t> *window)
+{
+    if (window != NULL)
     {
-        barHeight = (uint16_t)(deltaY_px * (y_data[i] - min_Y));
+        window->clear();
+    }
+    setStream(buffer, capacity, 0, 1);
+    streamWindow = window;
+}
 
-        if (canva_style.fill)
+void Graph_TFT::appendSample(uint16_t value)
+{
+    appendSamples(&value, 1);
+}
+
+void Graph_TFT::appendSamples(const uint16_t *values, uint16_t n)
+{
+    if (stream.getCapacity() == 0 || n == 0)
+        return;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        stream.push(values[i]);
+        if (streamWindow != NULL)
         {
-            tft->fillRect(x, startY - barHeight, deltaX_px, barHeight, canva_style.draw2);
+            streamWindow->push(values[i]);
         }
-        else
+    }
+    streamTotal += n;
+    if (retained)
+    {
+        pendingSamples += n;
+        return;
+    }
+
+    beginFrame();
+    if (!deferred())
+    {
+        drawAppended(n);
+    }
+    endFrame();
+}
+
+uint32_t Graph_TFT::drainSamples(Graph_Queue<uint16_t> &queue)
+{
+    if (stream.getCapacity() == 0)
+        return 0;
+
+    // Only what is there now, a fast producer must not keep the render looping
+    uint32_t n = queue.size();
+    uint16_t value;
+    for (uint32_t i = 0; i < n && queue.pop(value); i++)
+    {
+        stream.push(value);
+        if (streamWindow != NULL)
         {
-            tft->drawRect(x, startY - barHeight, deltaX_px, barHeight, canva_style.draw2);
+            streamWindow->push(value);
         }
+    }
+    streamTotal += n;
+    if (retained)
+    {
+        pendingSamples += n;
+    }
+    else if (n > 0)
+    {
+        beginFrame();
+        if (!deferred())
+        {
+            drawAppended(n);
+        }
+        endFrame();
+    }
+    return n;
+}
 
-        x += deltaX_px + 1; // span 1 px between bars
+bool Graph_TFT::rescaleStream(void)
+{
+    bool rescaled = false;
+    if (streamWindow != NULL && streamWindow->size() > 0)
+    {
+        uint16_t min = streamWindow->min();
+        uint16_t max = streamWindow->max();
+        if (autoscaleMode == NICE)
+        {
+            double lo = min, hi = max;
+            autoscale(lo, hi, true);
+            min = (lo > 0) ? lo : 0;
+            max = (hi < 0xFFFF) ? hi : 0xFFFF;
+        }
+        if (max <= min)
+        {
+            // Flat window, keep a range of one unit
+            min = (max > 0) ? max - 1 : 0;
+            max = min + 1;
+        }
+        rescaled = (min != streamMinY || max != streamMaxY);
+        streamMinY = min;
+        streamMaxY = max;
     }
+    return rescaled;
+}
 
-    drawLabels(deltaX_px, deltaY_px, min_Y, max_Y, 1, n_data);
+void Graph_TFT::drawAppended(uint32_t n)
+{
+    bool rescaled = rescaleStream();
+    uint16_t plotX = startX + 2;
+    uint16_t plotW = graphW - 2;
+    if (rescaled || !streamDrawn || n >= plotW || n >= stream.size())
+    {
+        drawStream();
+        return;
+    }
+
+    if (tft == &frame)
+    {
+        // Scroll the plot n columns to the left and draw the newest segments on the right
+        uint16_t x0 = plotX + plotW - n;
+        frame.scroll(plotX, endY, plotW, graphH, n);
+        tft->fillRect(x0, endY, n, graphH, canva_style.background);
+        int32_t py = streamPixel(stream[stream.size() - n - 1]);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int32_t ny = streamPixel(stream[stream.size() - n + i]);
+            tft->drawLine(x0 + i - 1, py, x0 + i, ny, canva_style.draw2);
+            py = ny;
+        }
+
+        fullFrame = false;
+        pushRect(plotX, endY, plotW, graphH);
+    }
+    else
+    {
+        // Sweep: overwrite the oldest columns and keep a blank column ahead of the cursor
+        int32_t py = streamPixel(stream[stream.size() - n - 1]);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int32_t ny = streamPixel(stream[stream.size() - n + i]);
+            uint16_t col = (streamTotal - n + i) % plotW;
+            tft->drawFastVLine(plotX + col, endY, graphH, canva_style.background);
+            if (col + 1 < plotW)
+            {
+                tft->drawFastVLine(plotX + col + 1, endY, graphH, canva_style.background);
+            }
+
+            if (col > 0)
+            {
+                tft->drawLine(plotX + col - 1, py, plotX + col, ny, canva_style.draw2);
+            }
+            else
+            {
+                tft->drawPixel(plotX, ny, canva_style.draw2);
+            }
+            py = ny;
+        }
+    }
 }
 
-void Graph_TFT::drawLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y)
+void Graph_TFT::drawStream(void)
 {
-    drawBackground();
-    drawAxis();
-    drawTitle();
+    invalidate();
+    GRAPH_LABELS labels = {0, streamMinY, streamMaxY, 1, 0, labelStepY};
+    drawStatic(true, &labels);
+    drawLabels(labels);
+
+    uint16_t plotX = startX + 2;
+    uint16_t plotW = graphW - 2;
+    uint16_t n = (stream.size() < plotW) ? stream.size() : plotW;
+    bool scrolling = (tft == &frame);
+    int32_t py = 0;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        int32_t ny = streamPixel(stream[stream.size() - n + i]);
+        uint16_t col = scrolling ? plotW - n + i : (streamTotal - n + i) % plotW;
+
+        if (i > 0 && col > 0)
+        {
+            tft->drawLine(plotX + col - 1, py, plotX + col, ny, canva_style.draw2);
+        }
+        else
+        {
+            tft->drawPixel(plotX + col, ny, canva_style.draw2);
+        }
+        py = ny;
+    }
 
-    if (max_Y == min_Y)
+    if (!scrolling && n == plotW)
+    {
+        tft->drawFastVLine(plotX + streamTotal % plotW, endY, graphH, canva_style.background);
+    }
+
+    streamDrawn = true;
+}
+
+void Graph_TFT::setHeatmap(uint8_t *buffer, uint16_t capacity, uint16_t bins, const uint16_t *lut, uint16_t lutSize)
+{
+    heat = Graph_Heatmap(buffer, capacity, bins, lut, lutSize);
+    heatTotal = 0;
+    stream = Graph_Ring<uint16_t>();
+    data.draw = NULL;
+    pendingSamples = 0;
+    if (retained)
+    {
+        dirtyStatic = true;
         return;
+    }
 
-    float deltaX_px = (graphW - (n_data + 1)) / n_data;
-    float deltaY_px = graphH / (max_Y - min_Y);
+    beginFrame();
+    if (!deferred())
+    {
+        drawHeatmap();
+    }
+    endFrame();
+}
 
-    uint16_t *x_data_sorted = new uint16_t[n_data];
-    uint16_t *y_data_sorted = new uint16_t[n_data];
+void Graph_TFT::drawHeatmap(void)
+{
+    invalidate();
+    GRAPH_LABELS labels = {0, 0, (long)heat.getBins() - 1, 1, 0, 0};
+    drawStatic(true, &labels);
+    drawLabels(labels);
 
-    memcpy(x_data_sorted, x_data, n_data * sizeof(uint16_t));
-    memcpy(y_data_sorted, y_data, n_data * sizeof(uint16_t));
+    uint16_t plotX = startX + 2;
+    uint16_t plotW = graphW - 2;
+    uint16_t n = (heat.size() < plotW) ? heat.size() : plotW;
+    bool scrolling = (tft == &frame);
 
-    quickSortX(x_data_sorted, y_data_sorted, 0, n_data - 1);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        uint16_t col = scrolling ? plotW - n + i : (heatTotal - n + i) % plotW;
+        drawColumn(heat.size() - n + i, plotX + col);
+    }
 
-    uint16_t min_X = x_data_sorted[0];
-    uint16_t max_X = x_data_sorted[n_data - 1];
+    if (!scrolling && n == plotW)
+    {
+        tft->drawFastVLine(plotX + heatTotal % plotW, endY, graphH, canva_style.background);
+    }
+
+    heatDrawn = true;
+}
 
-    uint16_t xs = startX + deltaX_px / 2 + 1;
-    uint16_t ys = startY - deltaY_px * (y_data_sorted[0] - min_Y);
-    uint16_t xe = 0, ye = 0;
+void Graph_TFT::drawColumns(uint32_t n)
+{
+    uint16_t plotX = startX + 2;
+    uint16_t plotW = graphW - 2;
+    if (!heatDrawn || n >= plotW || n >= heat.size())
+    {
+        drawHeatmap();
+        return;
+    }
 
-    for (uint8_t i = 1; i <= n_data; i++)
+    if (tft == &frame)
     {
-        if (canva_style.fill)
+        // Scroll the plot n columns to the left and draw the newest ones on the right
+        frame.scroll(plotX, endY, plotW, graphH, n);
+        for (uint32_t i = 0; i < n; i++)
         {
-            tft->fillCircle(xs, ys, 2, canva_style.draw2);
+            drawColumn(heat.size() - n + i, plotX + plotW - n + i);
         }
-        else
+
+        fullFrame = false;
+        pushRect(plotX, endY, plotW, graphH);
+    }
+    else
+    {
+        // Sweep: overwrite the oldest columns and keep a blank column ahead of the cursor
+        for (uint32_t i = 0; i < n; i++)
         {
-            tft->drawCircle(xs, ys, 2, canva_style.draw2);
+            uint16_t col = (heatTotal - n + i) % plotW;
+            drawColumn(heat.size() - n + i, plotX + col);
+            if (col + 1 < plotW)
+            {
+                tft->drawFastVLine(plotX + col + 1, endY, graphH, canva_style.background);
+            }
         }
+    }
+}
 
-        if (i != n_data)
+void Graph_TFT::drawColumn(uint16_t i, int32_t x)
+{
+    size_t mark = scratch.mark();
+    // A display list keeps images by reference, the column can't live in the scratch memory
+    uint16_t *pixels = listing() ? NULL : scratch.alloc<uint16_t>(graphH);
+    if (pixels != NULL)
+    {
+        heat.render(i, pixels, graphH);
+        tft->pushImage(x, endY, 1, graphH, pixels);
+    }
+    else
+    {
+        for (uint16_t r = 0; r < graphH;)
         {
-            xe = xs + deltaX_px + 1;
-            ye = startY - deltaY_px * (y_data_sorted[i] - min_Y);
-
-            tft->drawLine(xs, ys, xe, ye, canva_style.draw2);
-            xs = xe;
-            ys = ye;
+            uint8_t level = heat.level(i, r, graphH);
+            uint16_t run = 1;
+            while (r + run < graphH && heat.level(i, r + run, graphH) == level)
+            {
+                run++;
+            }
+            tft->drawFastVLine(x, endY + r, run, heat.color(level));
+            r += run;
         }
     }
+    scratch.release(mark);
+}
 
-    drawLabels(deltaX_px, deltaY_px, min_Y, max_Y, min_X, max_X);
-
-    delete[] x_data_sorted;
-    delete[] y_data_sorted;
+int32_t Graph_TFT::streamPixel(uint16_t value)
+{
+    value = (value < streamMinY) ? streamMinY : value;
+    value = (value > streamMaxY) ? streamMaxY : value;
+    return startY - 1 - (int32_t)(value - streamMinY) * (graphH - 1) / (streamMaxY - streamMinY);
 }
 
-void Graph_TFT::drawLabels(uint16_t deltaX_px, uint16_t deltaY_px, uint16_t min_Y, uint16_t max_Y, uint16_t min_X, uint16_t max_X)
+void Graph_TFT::drawLabels(const GRAPH_LABELS &labels)
 {
+    if (labelsDrawn)
+        return;
+
+    GRAPH_PHASE_SCOPE(PHASE_LABELS);
+    uint16_t deltaX_px = labels.deltaX_px;
+    long min_Y = labels.min_Y;
+    long max_Y = labels.max_Y;
+    long min_X = labels.min_X;
+    long max_X = labels.max_X;
+
     // Draw X-axis labels
-    if (canva_style.x_axis)
+    if (canva_style.x_axis && canva_style.axisDivX > 0)
     {
         uint16_t x = deltaX_px / 2;
         uint16_t x_increment = (deltaX_px + 1) * canva_style.axisDivX;
 
-        for (uint16_t i = min_X; i <= max_X; i += canva_style.axisDivX)
+        for (int64_t i = min_X; i <= max_X && x < graphW; i += canva_style.axisDivX)
         {
             tft->drawNumber(i, startX + x, startY + 2);
             x += x_increment;
@@ -140,67 +956,89 @@ void Graph_TFT::drawLabels(uint16_t deltaX_px, uint16_t deltaY_px, uint16_t min_
     }
 
     // Draw Y-axis labels
-    if (canva_style.y_axis)
+    if (canva_style.y_axis && canva_style.axisDivY > 0 && max_Y >= min_Y)
     {
+        int64_t range = (int64_t)max_Y - min_Y;
+        int64_t divY = (labels.stepY > 0) ? labels.stepY : canva_style.axisDivY;
+        int64_t rows = graphH / (8 * TEXT_SIZE);
+        if (rows > 0 && range / divY > rows)
+        {
+            // Wide ranges get no more labels than text rows, still on the ticks if any
+            int64_t tick = (labels.stepY > 0) ? labels.stepY : 1;
+            divY = ((range + rows - 1) / rows + tick - 1) / tick * tick;
+        }
+
         uint16_t y_position = 0;
-        for (uint16_t i = min_Y; i <= max_Y; i += canva_style.axisDivY)
+        for (int64_t i = min_Y; i <= max_Y; i += divY)
         {
-            y_position = startY - (i - min_Y) * deltaY_px;
+            y_position = (range > 0) ? startY - (i - min_Y) * graphH / range : startY;
             tft->drawNumber(i, canva_style.x + 2, y_position - 2);
             tft->drawPixel(startX + 1, y_position, canva_style.draw1);
         }
     }
 }
 
-void Graph_TFT::drawPIE(uint8_t *percentage, uint8_t n_data, const char *labels[])
+template <typename T>
+void Graph_TFT::drawPIE(const T *values, uint8_t n_data, const char *labels[])
 {
-    drawBackground();
-    drawTitle();
+    invalidate();
+    drawStatic(false);
 
-    uint8_t acc = 0;
-    for(uint8_t i = 0; i < n_data; i++)
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < n_data; i++)
     {
-        acc+= percentage[i];
+        total += values[i];
     }
-    if(acc != 100){
+    if (total == 0)
+    {
         return;
     }
-    delete &acc;
 
-    const uint16_t colors[5] = {0x08aa, 0x1ad5, 0xa236, 0xf334, 0xfd36};
-    const double conversion = 62.832e-3; // Equivalent to 2 * PI / 100 (to convert percentage to radians)
-    uint8_t radius = (graphH < graphW) ? graphH / 2 : graphW / 2;
-    uint16_t sx = startX + graphW / 2;
-    uint16_t sy = startY - graphH / 2;
-    uint8_t start = 0, end = 0;
-    uint16_t ex, ey, lx, ly, midpoint;
+    const uint16_t *colors = (palette != NULL) ? palette : defaultPalette;
+    uint8_t n_colors = (palette != NULL) ? paletteSize : sizeof(defaultPalette) / sizeof(defaultPalette[0]);
+    int32_t radius = (graphH < graphW) ? graphH / 2 : graphW / 2;
+    int32_t sx = startX + graphW / 2;
+    int32_t sy = startY - graphH / 2;
 
-    for (uint8_t i = 0; i < n_data; i++)
+    // One pass over the scanlines, each half row is split at the slice boundaries it crosses
+    for (int32_t dy = -radius; dy <= radius; dy++)
     {
-        end = start + percentage[i];
-
-        for (uint8_t p = start; p < end; p++)
-        {
-            double p_conv = p * conversion;
-            double p1_conv = (p + 1) * conversion;
+        int32_t w = isqrt(radius * radius - dy * dy);
+        PieWalker<T> right(values, n_data, total, dy, w, 1);
+        PieWalker<T> left(values, n_data, total, dy, w, -1);
 
-            ex = sx + radius * sin(p_conv);
-            ey = sy - radius * cos(p_conv);
+        int32_t rFrom, rTo, lFrom, lTo;
+        uint8_t rSlice, lSlice;
+        bool hasRight = right.next(rFrom, rTo, rSlice);
+        bool hasLeft = left.next(lFrom, lTo, lSlice);
 
-            // Draw each triangle for the pie slice
-            tft->fillTriangle(sx, sy,
-                              sx + radius * sin(p1_conv), sy - radius * cos(p1_conv),
-                              ex, ey, colors[i % 5]);
+        // The innermost spans of both halves are joined when they belong to the same slice
+        if (hasRight && hasLeft && rSlice == lSlice)
+        {
+            tft->drawFastHLine(sx - lTo, sy + dy, lTo + rTo + 1, colors[rSlice % n_colors]);
+            hasRight = right.next(rFrom, rTo, rSlice);
+            hasLeft = left.next(lFrom, lTo, lSlice);
         }
+        for (; hasRight; hasRight = right.next(rFrom, rTo, rSlice))
+        {
+            tft->drawFastHLine(sx + rFrom, sy + dy, rTo - rFrom + 1, colors[rSlice % n_colors]);
+        }
+        for (; hasLeft; hasLeft = left.next(lFrom, lTo, lSlice))
+        {
+            tft->drawFastHLine(sx - lTo, sy + dy, lTo - lFrom + 1, colors[lSlice % n_colors]);
+        }
+    }
 
-        // Compute midpoint for labels
-        midpoint = (start + end) / 2;
-        double midpoint_conv = midpoint * conversion;
-
-        lx = sx + 1.1 * radius * sin(midpoint_conv);
-        ly = sy - 1.1 * radius * cos(midpoint_conv);
+    // Labels at the middle of each slice, slightly outside of the pie
+    GRAPH_PHASE_SCOPE(PHASE_LABELS);
+    uint32_t cum = 0;
+    for (uint8_t i = 0; i < n_data; i++)
+    {
+        uint16_t midpoint = (uint64_t)(2 * cum + values[i]) * GRAPH_ANGLE_FULL / (2 * total);
+        int32_t lx = sx + 11 * radius * graphSin(midpoint) / (10 * GRAPH_TRIG_ONE);
+        int32_t ly = sy - 11 * radius * graphCos(midpoint) / (10 * GRAPH_TRIG_ONE);
 
-        tft->drawNumber(percentage[i], lx, ly);
+        tft->drawNumber(((uint32_t)values[i] * 100 + total / 2) / total, lx, ly);
 
         // draw labels if provided
         if (labels != NULL)
@@ -208,82 +1046,227 @@ void Graph_TFT::drawPIE(uint8_t *percentage, uint8_t n_data, const char *labels[
             tft->drawString(labels[i], lx - 8, ly - 8);
         }
 
-        start = end;
+        cum += values[i];
     }
 }
 
-void Graph_TFT::drawLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t y_limit)
+template <typename T>
+void Graph_TFT::renderPIE(Graph_TFT &graph, const GRAPH_DATA &data)
 {
-    drawBackground();
-    drawAxis();
-    drawTitle();
+    graph.drawPIE((const T *)data.y_data, data.n_data, data.labels);
+}
+
+void Graph_TFT::setDataPIE(uint8_t *percentage, uint8_t n_data)
+{
+    setData(renderPIE<uint8_t>, NULL, percentage, n_data, NULL, NULL, 0);
+}
+
+void Graph_TFT::setDataPIE(uint8_t *percentage, uint8_t n_data, const char *labels[])
+{
+    setData(renderPIE<uint8_t>, NULL, percentage, n_data, NULL, NULL, 0, labels);
+}
+
+void Graph_TFT::setDataPIE(uint16_t *values, uint8_t n_data)
+{
+    setData(renderPIE<uint16_t>, NULL, values, n_data, NULL, NULL, 0);
+}
+
+void Graph_TFT::setDataPIE(uint16_t *values, uint8_t n_data, const char *labels[])
+{
+    setData(renderPIE<uint16_t>, NULL, values, n_data, NULL, NULL, 0, labels);
+}
+
+void Graph_TFT::setData(void (*draw)(Graph_TFT &, const GRAPH_DATA &), const void *x_data, const void *y_data, uint32_t n_data,
+                        const void *min_Y, const void *max_Y, size_t size, const char **labels, bool scan,
+                        uint8_t n_series, bool stacked)
+{
+    data.draw = draw;
+    data.x_data = x_data;
+    data.y_data = y_data;
+    data.n_data = n_data;
+    data.n_series = n_series;
+    data.stacked = stacked;
+    data.fixedMin = (min_Y != NULL);
+    data.fixedMax = (max_Y != NULL);
+    if (min_Y != NULL)
+    {
+        memcpy(data.min_Y, min_Y, size);
+    }
+    if (max_Y != NULL)
+    {
+        memcpy(data.max_Y, max_Y, size);
+    }
+    data.labels = labels;
+    data.scan = scan;
+
+    if (retained)
+    {
+        dirtyData = true;
+        return;
+    }
+
+    beginFrame();
+    if (!deferred())
+    {
+        draw(*this, data);
+    }
+    endFrame();
+}
 
-    float deltaX_px = (graphW - (n_data + 1)) / n_data;
-    float deltaY_px = graphH / y_limit;
+void Graph_TFT::setRetained(bool enable)
+{
+    retained = enable;
+    dirtyStatic = true;
+}
 
-    uint16_t x_data_sorted[n_data], y_data_sorted[n_data];
-    memcpy(x_data_sorted, x_data, n_data * sizeof(uint16_t));
-    memcpy(y_data_sorted, y_data, n_data * sizeof(uint16_t));
-    quickSortX(x_data_sorted, y_data_sorted, 0, n_data - 1);
+bool Graph_TFT::render(void)
+{
+    if (!isDirty())
+        return false;
 
-    uint16_t xs = startX + deltaX_px * x_data_sorted[0] + 2;
-    uint16_t ys = startY - deltaY_px * y_data_sorted[0];
-    uint16_t xe = 0;
-    uint16_t ye = 0;
-    for (uint8_t i = 1; i < n_data; i++)
+    beginFrame();
+    if (dirtyStatic)
+    {
+        // Style or title changed, nothing on screen can be reused
+        invalidate();
+    }
+
+    if (!deferred())
+    {
+        drawScene(dirtyStatic);
+    }
+    endFrame();
+
+    dirtyStatic = false;
+    dirtyData = false;
+    pendingSamples = 0;
+    return true;
+}
+
+void Graph_TFT::drawScene(bool full)
+{
+    if (data.draw != NULL)
     {
-        if (canva_style.fill)
+        data.draw(*this, data);
+    }
+    else if (stream.getCapacity() > 0)
+    {
+        if (full)
         {
-            tft->fillCircle(xs, ys, 2, canva_style.draw2);
+            rescaleStream();
+            drawStream();
         }
         else
         {
-            tft->drawCircle(xs, ys, 2, canva_style.draw2);
+            drawAppended(pendingSamples);
+        }
+    }
+    else if (heat.getCapacity() > 0)
+    {
+        if (full)
+        {
+            drawHeatmap();
         }
-        if (i != n_data)
+        else
         {
-            xe = startX + deltaX_px * x_data_sorted[i] + 2;
-            ye = startY - deltaY_px * y_data_sorted[i];
-            tft->drawLine(xs, ys, xe, ye, canva_style.draw2);
+            drawColumns(pendingSamples);
         }
-        xs = xe;
-        ys = ye;
     }
+    else
+    {
+        drawStatic(false);
+    }
+}
+
+bool Graph_TFT::update(uint32_t now)
+{
+    if (!isDirty() || (framed && now - lastFrame < frameInterval))
+        return false;
 
-    if (canva_style.x_axis)
+    framed = true;
+    lastFrame = now;
+    return render();
+}
+
+void Graph_TFT::setFrameRate(uint16_t fps)
+{
+    frameInterval = (fps > 0) ? 1000000UL / fps : 0;
+}
+
+void Graph_TFT::setPalette(const uint16_t *colors, uint8_t n_colors)
+{
+    palette = (n_colors > 0) ? colors : NULL;
+    paletteSize = n_colors;
+    dirtyStatic = true;
+    invalidate();
+}
+
+void Graph_TFT::drawStamp(int32_t x, int32_t y, uint16_t color)
+{
+    if (marker == DOT)
     {
-        uint8_t x = 0;
-        for (uint8_t i = 0; i < n_data / canva_style.axisDivX; i++)
-        {
-            tft->drawNumber(canva_style.axisDivX * i + 1, 2 + startX + x, startY + 2);
-            x += (deltaX_px + 1) * canva_style.axisDivX;
-        }
+        tft->drawPixel(x, y, color);
+        return;
     }
 
-    if (canva_style.y_axis)
+    int32_t left = startX + 2;
+    int32_t right = startX + graphW;
+    for (int32_t r = 0; r < 5; r++)
     {
-        for (uint8_t i = 0; i <= y_limit; i += canva_style.axisDivY)
+        int32_t py = y + r - 2;
+        int32_t x0 = x + stamps[marker][r][0];
+        int32_t x1 = x0 + stamps[marker][r][1];
+        if (x1 == x0 || py < endY || py >= startY)
+            continue;
+        x0 = (x0 > left) ? x0 : left;
+        x1 = (x1 < right) ? x1 : right;
+        if (x1 > x0)
         {
-            tft->drawNumber(i, canva_style.x + 2, startY - i * deltaY_px - 2);
-            tft->drawPixel(startX + 1, startY - i * deltaY_px, canva_style.draw1);
+            tft->drawFastHLine(x0, py, x1 - x0, color);
         }
     }
 }
 
-void Graph_TFT::setDataPIE(uint8_t *percentage, uint8_t n_data)
+void Graph_TFT::setMarker(GRAPH_MARKER shape)
 {
-    drawPIE(percentage, n_data, NULL);
+    marker = shape;
+    dirtyStatic = true;
+    invalidate();
 }
 
-void Graph_TFT::setDataPIE(uint8_t *percentage, uint8_t n_data, const char *labels[])
+void Graph_TFT::setDensity(const uint16_t *lut, uint16_t size)
 {
-    drawPIE(percentage, n_data, labels);
+    densityLUT = (size > 0) ? lut : NULL;
+    densitySize = size;
+    dirtyStatic = true;
+    invalidate();
+}
+
+uint16_t Graph_TFT::seriesColor(uint8_t index, uint8_t n_series) const
+{
+    if (n_series <= 1)
+        return canva_style.draw2;
+    if (palette != NULL)
+        return palette[index % paletteSize];
+    if (index == 0)
+        return canva_style.draw2;
+    return seriesPalette[(index - 1) % (sizeof(seriesPalette) / sizeof(seriesPalette[0]))];
 }
 
 void Graph_TFT::setTitle(char *str)
 {
     this->title = str;
-    drawTitle();
+    layerValid = false;
+    dirtyStatic = true;
+    if (retained)
+        return;
+
+    beginFrame();
+    if (!deferred())
+    {
+        drawTitle();
+    }
+    endFrame();
 }
 
 void Graph_TFT::setCanva(GRAPH_STYLE style)
@@ -300,77 +1283,122 @@ void Graph_TFT::setCanva(GRAPH_STYLE style)
     drawBackground();
 }
 
-void Graph_TFT::setDataBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y)
-{
-    uint16_t max = maxminValue(y_data, n_data, true);
-    uint16_t min = maxminValue(y_data, n_data, false);
-
-    min_Y = (min < min_Y) ? min : min_Y;
-    max_Y = (max > max_Y) ? max : max_Y;
-
-    drawBARS(y_data, n_data, min_Y, max_Y);
-}
-
-void Graph_TFT::setDataBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y)
+void Graph_TFT::setScratch(void *buffer, size_t size)
 {
-    uint16_t max_Y = maxminValue(y_data, n_data, true);
-    uint16_t min = maxminValue(y_data, n_data, false);
-
-    min_Y = (min < min_Y) ? min : min_Y;
-
-    drawBARS(y_data, n_data, min_Y, max_Y);
+    scratch = Graph_Arena(buffer, size);
 }
 
-void Graph_TFT::setDataBARS(uint16_t *y_data, uint8_t n_data)
+void Graph_TFT::setAutoscale(GRAPH_AUTOSCALE mode)
 {
-    drawBARS(y_data, n_data, maxminValue(y_data, n_data, false), maxminValue(y_data, n_data, true));
-}
-
-void Graph_TFT::setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y)
-{
-    uint16_t max = maxminValue(y_data, n_data, true);
-    uint16_t min = maxminValue(y_data, n_data, false);
-
-    min_Y = (min < min_Y) ? min : min_Y;
-    max_Y = (max > max_Y) ? max : max_Y;
-
-    drawLINES(x_data, y_data, n_data, min_Y, max_Y);
+    autoscaleMode = mode;
+    axisValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
-void Graph_TFT::setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y)
+void Graph_TFT::autoscale(double &min_Y, double &max_Y, bool integral)
 {
-    uint16_t max_Y = maxminValue(y_data, n_data, true);
-    uint16_t min = maxminValue(y_data, n_data, false);
-
-    min_Y = (min < min_Y) ? min : min_Y;
+    // Tick of 1, 2 or 5 x 10^k giving about GRAPH_AUTOSCALE_TICKS ticks, no more than the text rows
+    int32_t ticks = graphH / (8 * TEXT_SIZE);
+    ticks = (ticks > GRAPH_AUTOSCALE_TICKS) ? GRAPH_AUTOSCALE_TICKS : ((ticks > 0) ? ticks : 1);
+    double range = max_Y - min_Y;
+    if (!(range > 0))
+    {
+        range = (!integral && max_Y != 0) ? fabs(max_Y) / 10 : 1;
+    }
+    double raw = range / ticks;
+    double magnitude = 1;
+    while (magnitude * 10 <= raw)
+        magnitude *= 10;
+    while (magnitude > raw)
+        magnitude /= 10;
+    double f = raw / magnitude;
+    double step = ((f <= 1) ? 1 : (f <= 2) ? 2 : (f <= 5) ? 5 : 10) * magnitude;
+    step = (integral && step < 1) ? 1 : step;
+
+    double lo = floor(min_Y / step) * step;
+    double hi = ceil(max_Y / step) * step;
+    hi = (hi > lo) ? hi : lo + step;
+
+    if (!axisValid || min_Y < axisLo || max_Y > axisHi)
+    {
+        // The data left the axis, grow it at once
+        axisValid = true;
+        axisLo = lo;
+        axisHi = hi;
+        axisStep = step;
+        axisHold = 0;
+    }
+    else if ((hi - lo) * 2 <= axisHi - axisLo)
+    {
+        // The data fits in half of the axis, shrink it if that lasts (frames drawn in several passes count once)
+        axisHold += axisHeld ? 0 : 1;
+        axisHeld = true;
+        if (axisHold >= GRAPH_AUTOSCALE_HOLD)
+        {
+            axisLo = lo;
+            axisHi = hi;
+            axisStep = step;
+            axisHold = 0;
+        }
+    }
+    else
+    {
+        axisHold = 0;
+    }
 
-    drawLINES(x_data, y_data, n_data, min_Y, max_Y);
+    min_Y = axisLo;
+    max_Y = axisHi;
+    labelStepY = (long)axisStep;
 }
 
-void Graph_TFT::setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data)
+void Graph_TFT::setDecimation(GRAPH_DECIMATION mode)
 {
-    drawLINES(x_data, y_data, n_data, maxminValue(y_data, n_data, false), maxminValue(y_data, n_data, true));
+    decimation = mode;
+    dirtyStatic = true;
+    invalidate();
 }
 
 void Graph_TFT::setAxisDiv(uint8_t divX, uint8_t divY)
 {
     this->canva_style.axisDivX = divX;
     this->canva_style.axisDivY = divY;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
 void Graph_TFT::setBackgroudColour(uint16_t RGB565)
 {
+    if (styleLocked)
+        return;
+
     this->canva_style.background = RGB565;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
 void Graph_TFT::setDrawingPrimaryColour(uint16_t RGB565)
 {
+    if (styleLocked)
+        return;
+
     this->canva_style.draw1 = RGB565;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
 void Graph_TFT::setDrawingSecondaryColour(uint16_t RGB565)
 {
+    if (styleLocked)
+        return;
+
     this->canva_style.draw2 = RGB565;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
 uint16_t Graph_TFT::getWidth(void)
@@ -387,119 +1415,37 @@ void Graph_TFT::setAxis(bool x_axis, bool y_axis)
 {
     this->canva_style.x_axis = x_axis;
     this->canva_style.y_axis = y_axis;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
 
 void Graph_TFT::setStyle(GRAPH_STYLE style)
 {
+    if (styleLocked)
+        return;
+
     switch (style)
     {
-    case BLACK:
-        canva_style.background = COLOR_BLACK;
-        canva_style.draw1 = COLOR_WHITE;
-        canva_style.draw2 = COLOR_WHITE;
-        canva_style.fill = false;
-        break;
     case NEON:
-        canva_style.background = COLOR_BLACK;
-        canva_style.draw1 = COLOR_WHITE;
-        canva_style.draw2 = COLOR_NEON_RED;
-        canva_style.fill = false;
+        applyTheme<NEON>();
         break;
     case PAPER:
-        canva_style.background = COLOR_PAPER;
-        canva_style.draw1 = COLOR_BLUE_INK;
-        canva_style.draw2 = COLOR_NEON_RED;
-        canva_style.fill = false;
+        applyTheme<PAPER>();
         break;
     case OCEAN:
-        canva_style.background = COLOR_DARK_SEA;
-        canva_style.draw1 = COLOR_WHITE;
-        canva_style.draw2 = COLOR_SAND;
-        canva_style.fill = true;
+        applyTheme<OCEAN>();
         break;
     case CAKE:
-        canva_style.background = COLOR_WHITE;
-        canva_style.draw1 = COLOR_NEON_RED;
-        canva_style.draw2 = COLOR_PASTEL_PURPLE;
-        canva_style.fill = true;
+        applyTheme<CAKE>();
         break;
     default:
-        canva_style.background = COLOR_BLACK;
-        canva_style.draw1 = COLOR_WHITE;
-        canva_style.draw2 = COLOR_WHITE;
-        canva_style.fill = false;
+        applyTheme<BLACK>();
         break;
     }
     tft->setTextSize(TEXT_SIZE);
     tft->setTextColor(canva_style.draw1, canva_style.background, false);
-}
-
-void Graph_TFT::quickSortX(uint16_t *arrX, uint16_t *arrY, uint8_t left, uint8_t right)
-{
-    if (left < right)
-    {
-        // Obtiene el índice de partición
-        uint8_t pivotIndex = partition(arrX, arrY, left, right);
-
-        // Ordena las dos subpartes de forma recursiva
-        quickSortX(arrX, arrY, left, pivotIndex - 1);
-        quickSortX(arrX, arrY, pivotIndex + 1, right);
-    }
-}
-
-uint8_t Graph_TFT::partition(uint16_t *arrX, uint16_t *arrY, uint8_t left, uint8_t right)
-{
-    uint16_t pivot = arrX[right];
-    uint8_t i = left - 1;
-
-    for (uint8_t j = left; j < right; j++)
-    {
-        if (arrX[j] < pivot)
-        {
-            i++;
-
-            swap(&arrX[i], &arrX[j]);
-
-            if (arrY != NULL)
-            {
-                swap(&arrY[i], &arrY[j]);
-            }
-        }
-    }
-
-    swap(&arrX[i + 1], &arrX[right]);
-
-    if (arrY != NULL)
-    {
-        swap(&arrY[i + 1], &arrY[right]);
-    }
-
-    return i + 1;
-}
-
-void Graph_TFT::swap(uint16_t *a, uint16_t *b)
-{
-    uint16_t temp = *a;
-    *a = *b;
-    *b = temp;
-}
-
-uint16_t Graph_TFT::maxminValue(uint16_t *y_data, uint8_t n_data, bool max)
-{
-    if (n_data == 0)
-        return 0;
-
-    uint16_t val = y_data[0];
-    for (int i = 1; i < n_data; i++)
-    {
-        if (max)
-        {
-            val = (val < y_data[i]) ? y_data[i] : val;
-        }
-        else
-        {
-            val = (val > y_data[i]) ? y_data[i] : val;
-        }
-    }
-    return val;
+    layerValid = false;
+    dirtyStatic = true;
+    invalidate();
 }
@@ -1,5 +1,17 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "Graph_Target.h"
+#include "Graph_Raster.h"
+#include "Graph_List.h"
+#include "Graph_Ring.h"
+#include "Graph_Queue.h"
+#include "Graph_Window.h"
+#include "Graph_Heatmap.h"
+#include "Graph_Series.h"
+#include "Graph_Arena.h"
+#include "Graph_Stats.h"
+#ifdef ARDUINO
+#include "Graph_eSPI.h"
+#endif
 
 #define CANVAS_WIDTH 128
 #define CANVAS_HEIGHT 128
@@ -22,6 +34,14 @@
 #define DEFAULT_AXIS_DIV 0
 #define DEFAULT_PADDING 15
 #define DEFAULT_ROUNDED 5
+#define GRAPH_MAX_BARS 32 // Bars remembered for incremental redraw
+
+/* Worst-case scratch memory of a render, in bytes */
+#define GRAPH_SCRATCH_LINES(n, X, Y) ((n) * (sizeof(X) + sizeof(Y)) + alignof(X) + alignof(Y)) // setDataLINES with unsorted x_data
+#define GRAPH_SCRATCH_HEATMAP(rows) ((rows) * sizeof(uint16_t) + alignof(uint16_t)) // setHeatmap, one column of pixels
+#define GRAPH_SCRATCH_SCATTER(w, h) (((w) * (h) + 7) / 8) // setDataSCATTER on a w x h canvas, occupancy bitmap
+#define GRAPH_SCRATCH_DENSITY(w, h) ((w) * (h))          // setDataSCATTER with density colouring, one count per px
+#define GRAPH_SCRATCH_SERIES(n, X, Y) ((n) * (sizeof(X) + sizeof(uint32_t) + sizeof(Y)) + alignof(X) + alignof(uint32_t) + alignof(Y)) // Several series with unsorted x_data
 
 /**
  * @struct CANVA_STYLE
@@ -60,18 +80,191 @@ typedef enum
     CAKE   ///< Cake style for the graph (colorful, possibly fun).
 } GRAPH_STYLE;
 
+/**
+ * @struct Graph_Theme
+ * @brief Colours of a GRAPH_STYLE, as compile-time constants.
+ */
+template <GRAPH_STYLE S>
+struct Graph_Theme
+{
+    static constexpr uint16_t background = COLOR_BLACK; ///< Background colour.
+    static constexpr uint16_t draw1 = COLOR_WHITE;      ///< Primary colour: frame, axis, labels and title.
+    static constexpr uint16_t draw2 = COLOR_WHITE;      ///< Secondary colour: data.
+    static constexpr bool fill = false;                 ///< Whether bars are filled.
+};
+
+template <>
+struct Graph_Theme<NEON>
+{
+    static constexpr uint16_t background = COLOR_BLACK;
+    static constexpr uint16_t draw1 = COLOR_WHITE;
+    static constexpr uint16_t draw2 = COLOR_NEON_RED;
+    static constexpr bool fill = false;
+};
+
+template <>
+struct Graph_Theme<PAPER>
+{
+    static constexpr uint16_t background = COLOR_PAPER;
+    static constexpr uint16_t draw1 = COLOR_BLUE_INK;
+    static constexpr uint16_t draw2 = COLOR_NEON_RED;
+    static constexpr bool fill = false;
+};
+
+template <>
+struct Graph_Theme<OCEAN>
+{
+    static constexpr uint16_t background = COLOR_DARK_SEA;
+    static constexpr uint16_t draw1 = COLOR_WHITE;
+    static constexpr uint16_t draw2 = COLOR_SAND;
+    static constexpr bool fill = true;
+};
+
+template <>
+struct Graph_Theme<CAKE>
+{
+    static constexpr uint16_t background = COLOR_WHITE;
+    static constexpr uint16_t draw1 = COLOR_NEON_RED;
+    static constexpr uint16_t draw2 = COLOR_PASTEL_PURPLE;
+    static constexpr bool fill = true;
+};
+
+/**
+ * @struct GRAPH_LABELS
+ * @brief Axis labels of a graph, two frames with equal labels draw the same label pixels.
+ */
+struct GRAPH_LABELS
+{
+    uint16_t deltaX_px; ///< Space between two x-axis labels in px, minus 1.
+    long min_Y;         ///< Minimun value for y-axis, at the bottom of the graph.
+    long max_Y;         ///< Maximum value for y-axis, at the top of the graph.
+    long min_X;         ///< Minimun value for x-axis.
+    long max_X;         ///< Maximum value for x-axis (lower than min_X for no x-axis labels).
+    long stepY;         ///< Step between two y-axis labels, 0 to follow the axis divisions.
+};
+
+/**
+ * @enum GRAPH_AUTOSCALE
+ * @brief Defines how the y-axis follows data given without limits.
+ */
+typedef enum
+{
+    EXACT, ///< From the lowest to the highest value, changing with almost every new value.
+    NICE   ///< Multiples of a 1/2/5 x 10^k tick, changed only when the data leaves it or stays well inside.
+} GRAPH_AUTOSCALE;
+
+/**
+ * @enum GRAPH_DECIMATION
+ * @brief Defines how series with more points than px columns are reduced to the plot width.
+ */
+typedef enum
+{
+    MINMAX, ///< Keep the lowest and highest point of every column, spikes are never lost.
+    LTTB    ///< Largest-Triangle-Three-Buckets, one point per column keeping the visual shape.
+} GRAPH_DECIMATION;
+
+/**
+ * @enum GRAPH_BARS
+ * @brief Defines how several series of bars share the x-axis.
+ */
+typedef enum
+{
+    GROUPED, ///< Side by side, one bar per series in every group.
+    STACKED  ///< On top of each other, one bar per data point made of one segment per series.
+} GRAPH_BARS;
+
+/**
+ * @enum GRAPH_MARKER
+ * @brief Defines the pre-rasterized marker stamped at every point of a scatter graph.
+ */
+typedef enum
+{
+    DOT,    ///< Single px.
+    PLUS,   ///< 3x3 cross.
+    SQUARE, ///< 3x3 square.
+    DISC    ///< 5x5 disc.
+} GRAPH_MARKER;
+
+/**
+ * @struct Graph_Geometry
+ * @brief Size of the graph and style read by the bar and line renderers, from the canvas at run time.
+ *
+ * The renderers take it as a template parameter: Graph_TFT_Fixed gives them one made of
+ * compile-time constants instead (Graph_Fixed_Geometry).
+ */
+struct Graph_Geometry
+{
+    uint16_t w;               ///< Width of the graph.
+    uint16_t h;               ///< Height of the graph.
+    const CANVA_STYLE &style; ///< Style of the canvas.
+
+    Graph_Geometry(uint16_t graphW, uint16_t graphH, const CANVA_STYLE &style) : w(graphW), h(graphH), style(style) {}
+
+    uint16_t graphW(void) const { return w; }
+    uint16_t graphH(void) const { return h; }
+    bool fill(void) const { return style.fill; }
+    uint16_t background(void) const { return style.background; }
+    uint16_t draw1(void) const { return style.draw1; }
+    uint16_t draw2(void) const { return style.draw2; }
+};
+
+class Graph_TFT;
+
+#define GRAPH_AUTOSCALE_TICKS 5 ///< Number of y-axis ticks aimed at by NICE autoscale.
+#define GRAPH_AUTOSCALE_HOLD 16 ///< Frames the data has to stay within half of a NICE axis before it shrinks.
+#define GRAPH_LIMIT_BYTES 16 ///< Storage of an axis limit of any arithmetic type.
+
+/**
+ * @struct GRAPH_DATA
+ * @brief Data of a graph kept by reference, with the function drawing it in the types it was given in.
+ */
+struct GRAPH_DATA
+{
+    void (*draw)(Graph_TFT &graph, const GRAPH_DATA &data); ///< Draws the data, NULL if none.
+    const void *x_data;                 ///< Values of the x-axis, NULL if none.
+    const void *y_data;                 ///< Values of the y-axis (values of the slices for PIE), or array of n_series series.
+    uint32_t n_data;                    ///< Number of data points.
+    uint8_t n_series;                   ///< Number of series pointed by y_data, 0 if y_data is a single series.
+    bool stacked;                       ///< Whether the series of bars are stacked rather than grouped.
+    uint8_t min_Y[GRAPH_LIMIT_BYTES];   ///< Lower limit of the y-axis, lowered to the data.
+    uint8_t max_Y[GRAPH_LIMIT_BYTES];   ///< Upper limit of the y-axis, raised to the data.
+    bool fixedMin;                      ///< Whether min_Y was given, otherwise it is the lowest value.
+    bool fixedMax;                      ///< Whether max_Y was given, otherwise it is the highest value.
+    bool scan;                          ///< Whether the limits are widened to the data, false if they come from a Graph_Window.
+    const char **labels;                ///< Labels of the PIE slices, NULL if none.
+};
+
 /**
  * @class Graph_TFT
  * @brief A class for graphing data on TFT displays using the TFT_eSPI library.
  *
  * This class allows creating and rendering different types of graphs (like bar, charts, ...) on TFT displays.
  * It uses various customizable parameters for the canvas, style, and axis divisions.
+ * Drawing goes through a Graph_Target, so the same graphs can be rendered on a panel or in RAM.
  */
 class Graph_TFT
 {
 private:
-    TFT_eSPI *tft;           ///< Pointer to the TFT display object.
+#ifdef ARDUINO
+    Graph_eSPI espi;         ///< Drawing target wrapping the TFT_eSPI display, when built from one.
+#endif
+    Graph_Target *panel;     ///< Pointer to the output drawing target.
+    Graph_Target *tft;       ///< Pointer to the drawing target of the frame being drawn (panel or framebuffer).
+    Graph_Raster frame;      ///< Off-screen framebuffer covering the canvas, empty in direct mode.
+    Graph_Raster layer;      ///< Cached static layer (background, frame, axis, title), empty if not supplied.
+    Graph_List lists[2];     ///< Display lists of the frame on screen and of the frame being drawn, empty if not supplied.
+    uint8_t shown = 0;       ///< Index of the list of the frame on screen.
+    bool listValid = false;  ///< Whether the list shown matches the screen.
+    Graph_Raster strip;      ///< Band of the canvas being rasterized in strip mode, empty if not supplied.
+    uint16_t stripRows = 0;  ///< Rows of the strip buffer, 0 if not in strip mode.
+    uint16_t screen = COLOR_BLACK; ///< Colour of the screen behind the rounded corners, in display list and strip modes.
+    bool layerValid = false; ///< Whether the static layer holds the current style and title.
+    bool layerAxis = false;  ///< Whether the static layer holds the frame and axis.
+    bool layerLabels = false; ///< Whether the static layer holds the axis labels.
+    GRAPH_LABELS labelsKey;  ///< Axis labels held by the static layer.
+    bool labelsDrawn = false; ///< Whether the axis labels of the frame came with the static layer.
     CANVA_STYLE canva_style; ///< Structure that defines the canvas style.
+    bool styleLocked = false; ///< Whether the style setters are ignored, the colours being constants of the type.
     uint16_t startX;         ///< X-coordinate of the starting point of the graph.
     uint16_t startY;         ///< Y-coordinate of the starting point of the graph.
     uint16_t endX;           ///< X-coordinate of the ending point of the graph.
@@ -79,6 +272,55 @@ private:
     uint16_t graphW;         ///< Width of the graph.
     uint16_t graphH;         ///< Height of the graph.
     char *title;             ///< Title of the graph.
+    bool fullFrame;          ///< Whether endFrame has to push the whole framebuffer.
+    uint16_t *spare = NULL;  ///< Second framebuffer in asynchronous mode, the one being sent to the panel.
+    bool presented = false;  ///< Whether the framebuffer was handed to the panel and must be swapped before drawing.
+    int32_t dirtyTop;        ///< First framebuffer row changed by the frame, in asynchronous mode.
+    int32_t dirtyBottom;     ///< Row after the last framebuffer row changed by the frame, in asynchronous mode.
+    uint16_t barHeights[GRAPH_MAX_BARS]; ///< Heights in px of the bars on screen.
+    uint8_t barCount;        ///< Number of bars on screen, 0 if the canvas doesn't hold bars.
+    double barMinY;          ///< Minimum of the y-axis of the bars on screen.
+    double barMaxY;          ///< Maximum of the y-axis of the bars on screen.
+    Graph_Ring<uint16_t> stream; ///< History of the streaming line graph.
+    uint32_t streamTotal;    ///< Number of samples appended since setStream.
+    uint16_t streamMinY;     ///< Minimum of the y-axis of the streaming line graph.
+    uint16_t streamMaxY;     ///< Maximum of the y-axis of the streaming line graph.
+    bool streamDrawn;        ///< Whether the streaming line graph is on screen.
+    Graph_Window<uint16_t> *streamWindow = NULL; ///< Window setting the y-axis of the streaming line graph, NULL for a fixed one.
+    Graph_Heatmap heat;      ///< History of the heatmap, empty if none.
+    uint32_t heatTotal = 0;  ///< Number of columns appended since setHeatmap.
+    bool heatDrawn = false;  ///< Whether the heatmap is on screen.
+    const uint16_t *palette = NULL; ///< Colours of the PIE slices and of the series, NULL for the default ones.
+    uint8_t paletteSize = 0;  ///< Number of colours of the palette.
+    GRAPH_DECIMATION decimation = MINMAX; ///< Decimation of the lines larger than the plot.
+    GRAPH_AUTOSCALE autoscaleMode = EXACT; ///< How the y-axis follows the data.
+    GRAPH_MARKER marker = DOT; ///< Marker of the scatter graphs.
+    const uint16_t *densityLUT = NULL; ///< Colours of the scatter points by number of points per px, NULL for a single colour.
+    uint16_t densitySize = 0; ///< Number of colours of densityLUT.
+    double axisLo = 0;       ///< Lower limit of the NICE y-axis.
+    double axisHi = 0;       ///< Upper limit of the NICE y-axis.
+    double axisStep = 0;     ///< Tick of the NICE y-axis.
+    bool axisValid = false;  ///< Whether the NICE y-axis was set.
+    uint8_t axisHold = 0;    ///< Consecutive frames the data stayed within half of the NICE y-axis.
+    bool axisHeld = false;   ///< Whether axisHold already counted the frame being drawn.
+    long labelStepY = 0;     ///< Step of the y-axis labels of the next frame, 0 to follow the axis divisions.
+    Graph_Arena scratch;     ///< Scratch memory of the renders, empty if not supplied.
+    GRAPH_DATA data = GRAPH_DATA(); ///< Data of the graph, drawn by render in retained mode.
+    bool retained = false;   ///< Whether the setters only record the changes, drawn by render.
+    bool dirtyStatic = true; ///< Whether the style or the title changed since the last render.
+    bool dirtyData = false;  ///< Whether the data changed since the last render.
+    uint32_t pendingSamples = 0; ///< Samples (or heatmap columns) appended since the last render.
+    uint32_t frameInterval = 0;  ///< Minimum time between two frames drawn by update, in microseconds.
+    uint32_t lastFrame = 0;  ///< Time of the last frame drawn by update.
+    bool framed = false;     ///< Whether update ever drew a frame.
+#if GRAPH_ENABLE_STATS
+    Graph_Stats stats;       ///< Per-phase statistics of the renders.
+#endif
+
+    /**
+     * @brief Build a canvas style from individual parameters.
+     */
+    static CANVA_STYLE makeCanva(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t padding, uint8_t rounded);
 
     /**
      * @brief Set the canvas style.
@@ -86,6 +328,38 @@ private:
      */
     void setCanva(GRAPH_STYLE style);
 
+    /**
+     * @brief Set the colours of a style.
+     */
+    template <GRAPH_STYLE S>
+    void applyTheme(void)
+    {
+        canva_style.background = Graph_Theme<S>::background;
+        canva_style.draw1 = Graph_Theme<S>::draw1;
+        canva_style.draw2 = Graph_Theme<S>::draw2;
+        canva_style.fill = Graph_Theme<S>::fill;
+    }
+
+    /**
+     * @brief Start a frame, redirecting the drawing to the framebuffer if any.
+     */
+    void beginFrame(void);
+
+    /**
+     * @brief End a frame, pushing the framebuffer to the panel in one block if any.
+     */
+    void endFrame(void);
+
+    /**
+     * @brief Push a rectangle of the framebuffer to the panel, if drawing to the framebuffer.
+     */
+    void pushRect(int32_t x, int32_t y, int32_t w, int32_t h);
+
+    /**
+     * @brief Forget what is on screen, so the next frame is fully redrawn.
+     */
+    void invalidate(void);
+
     /**
      * @brief Draw the graph's title.
      */
@@ -102,60 +376,276 @@ private:
     void drawAxis(void);
 
     /**
-     * @brief Draw a bar graph with the provided data.
+     * @brief Draw the static layer of the graph: background, title and optionally frame and axis.
+     *
+     * Copies the cached layer in one block when there is one, rasterizing it first if outdated.
+     * The axis labels are cached in the layer too, so frames with unchanged labels don't draw them.
+     * @param axis Whether to draw the frame and axis.
+     * @param labels Axis labels of the frame, drawn later by drawLabels (NULL for none).
+     */
+    void drawStatic(bool axis, const GRAPH_LABELS *labels = NULL);
+
+    /**
+     * @brief Draw the whole graph (full) or what changed since the last frame.
+     */
+    void drawScene(bool full);
+
+    /**
+     * @brief Whether the frames are recorded as display lists.
+     */
+    bool listing(void) const { return lists[0].getCapacity() > 0; }
+
+    /**
+     * @brief Whether the frames are rasterized in strips of the canvas.
+     */
+    bool striping(void) const { return stripRows > 0; }
+
+    /**
+     * @brief Whether endFrame draws the whole graph itself (display list or strips), so the
+     * setters don't draw between beginFrame and endFrame.
+     */
+    bool deferred(void) const { return listing() || striping(); }
+
+    /**
+     * @brief Draw the whole graph once per strip of the canvas and push every strip.
+     */
+    void drawStrips(void);
+
+    /**
+     * @brief Send the areas where the frame recorded differs from the one on screen.
+     */
+    void flushList(void);
+
+    /**
+     * @brief Rasterize a rectangle of the frame recorded in bands and push them.
+     *
+     * The bands go through the strip buffer in strip mode, through the scratch memory otherwise.
+     * @return false if the scratch memory can't hold a single row.
+     */
+    bool drawBands(const Graph_List &list, GRAPH_RECT area);
+
+    /**
+     * @brief Start the palette of an indexed framebuffer over with the colours of the style.
+     */
+    void mapPalette(void);
+
+    /**
+     * @brief Draw a bar graph with the provided data, one or several series.
+     * @param series Array of n_series arrays containing y-axis data for the bars.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     * @param stacked Whether to stack the series rather than group them.
+     */
+    template <class G, typename T, typename I>
+    void drawBARS(const T *const *series, uint8_t n_series, I n_data, T min_Y, T max_Y, bool stacked);
+
+    /**
+     * @brief Update the bars on screen, only touching the rows between their old and new heights.
+     *
+     * Requires the same number of bars and y-axis range than the bars on screen.
      * @param y_data Array containing y-axis data for the bars.
      * @param n_data Number of data points.
      * @param min_Y Minimun value for y-axis scaling.
      * @param max_Y Maximum value for y-axis scaling.
      */
-    void drawBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y);
+    template <class G, typename T, typename I>
+    void updateBARS(const T *y_data, I n_data, T min_Y, T max_Y);
 
     /**
-     * @brief Draw labels of the graph.
-     * @param deltaX_px space of x axis in px.
-     * @param deltaY_px space of y axis in px.
-     * @param min_Y Minimun value for y-axis.
-     * @param max_Y Maximum value for y-axis.
-     * @param min_X Minimun value for x-axis.
-     * @param max_X Maximum value for x-axis.
+     * @brief Draw a series with more points than px columns, as one min/max pair per column.
+     *
+     * Drawing costs a few primitives per column whatever the number of points.
+     * @param y_data Array containing y-axis data, in x order.
+     * @param n_data Number of data points, at least cols.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     * @param x Screen X-coordinate of the first column.
+     * @param cols Number of px columns.
+     * @param bars true to draw each column from the x-axis up to its maximum, false to join the columns as a line.
+     * @param color Colour of the series (RGB565 format).
      */
-    void drawLabels(uint16_t deltaX_px, uint16_t deltaY_px, uint16_t min_Y, uint16_t max_Y, uint16_t min_X, uint16_t max_X);
+    template <class G, typename Y>
+    void drawMinMax(const Y *y_data, uint32_t n_data, Y min_Y, Y max_Y, int32_t x, uint16_t cols, bool bars, uint16_t color);
 
     /**
-     * @brief Draw a bar graph with the provided data.
-     * @param x_data Array containing y-axis data for the bars.
-     * @param y_data Array containing y-axis data for the bars.
+     * @brief Draw a series with more points than px columns as a line through one point per column,
+     * picked with Largest-Triangle-Three-Buckets.
+     * @param y_data Array containing y-axis data, in x order.
+     * @param n_data Number of data points, at least cols.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     * @param x Screen X-coordinate of the first column.
+     * @param cols Number of px columns.
+     * @param color Colour of the series (RGB565 format).
+     */
+    template <class G, typename Y>
+    void drawLTTB(const Y *y_data, uint32_t n_data, Y min_Y, Y max_Y, int32_t x, uint16_t cols, uint16_t color);
+
+    /**
+     * @brief Draw the whole streaming line graph from its history.
+     */
+    void drawStream(void);
+
+    /**
+     * @brief Follow the range of the window of the streaming line graph, if any.
+     * @return Whether the y-axis changed.
+     */
+    bool rescaleStream(void);
+
+    /**
+     * @brief Draw the n newest samples of the streaming line graph, already in its history.
+     *
+     * The whole graph is redrawn if its y-axis follows a window whose range changed.
+     */
+    void drawAppended(uint32_t n);
+
+    /**
+     * @brief Draw the whole heatmap from its history.
+     */
+    void drawHeatmap(void);
+
+    /**
+     * @brief Draw the n newest columns of the heatmap, already in its history.
+     *
+     * In framebuffer mode the plot scrolls and is pushed in one block, otherwise each column is
+     * pushed in one block at the sweeping cursor.
+     */
+    void drawColumns(uint32_t n);
+
+    /**
+     * @brief Draw a column of the heatmap as one block of pixels (runs of one colour without scratch memory).
+     * @param i Index of the column in the history, 0 being the oldest one.
+     * @param x Screen X-coordinate of the column.
+     */
+    void drawColumn(uint16_t i, int32_t x);
+
+    /**
+     * @brief Get the screen Y-coordinate of a sample of the streaming line graph.
+     * @param value Sample value, clamped to the y-axis range.
+     */
+    int32_t streamPixel(uint16_t value);
+
+    /**
+     * @brief Draw labels of the graph, unless they already came with the static layer.
+     * @param labels Axis labels, as given to drawStatic.
+     */
+    void drawLabels(const GRAPH_LABELS &labels);
+
+    /**
+     * @brief Draw a lines graph with the provided data, one line per series over shared axes.
+     * @param x_data Array containing x-axis data, shared by the series.
+     * @param series Array of n_series arrays containing y-axis data.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     */
+    template <class G, typename X, typename Y, typename I>
+    void drawLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data, Y min_Y, Y max_Y);
+
+    /**
+     * @brief Draw a scatter graph, every point stamped once per px it lands on.
+     * @param x_data Array containing x-axis data.
+     * @param y_data Array containing y-axis data.
      * @param n_data Number of data points.
+     * @param min_X Minimun value for x-axis scaling.
+     * @param max_X Maximum value for x-axis scaling.
      * @param min_Y Minimun value for y-axis scaling.
      * @param max_Y Maximum value for y-axis scaling.
      */
-    void drawLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y);
+    template <typename X, typename Y, typename I>
+    void drawSCATTER(const X *x_data, const Y *y_data, I n_data, X min_X, X max_X, Y min_Y, Y max_Y);
+
+    /**
+     * @brief Stamp the marker centred on a px of the plot, clipped to the plot.
+     */
+    void drawStamp(int32_t x, int32_t y, uint16_t color);
+
+    /**
+     * @brief Get the colour of a series: the secondary colour for a single one, the palette otherwise.
+     * @param index Index of the series.
+     * @param n_series Number of series.
+     */
+    uint16_t seriesColor(uint8_t index, uint8_t n_series) const;
 
     /**
-     * @brief Draw a PIE graph with the percentage.
-     * @param percentage Array containing percentage data.
+     * @brief Draw a PIE graph, one scanline pass with one span per slice and row.
+     * @param values Array containing the value of each slice, normalized to their total.
      * @param n_data Number of data points.
      * @param labels array of labels.
      */
-    void drawPIE(uint8_t *percentage, uint8_t n_data, const char *labels[]);
+    template <typename T>
+    void drawPIE(const T *values, uint8_t n_data, const char *labels[]);
 
     /**
-     * @brief Draw a bar graph with the provided data.
-     * @param x_data Array containing y-axis data for the bars.
-     * @param y_data Array containing y-axis data for the bars.
-     * @param n_data Number of data points.
-     * @param y_limit Maximum value for y-axis scaling.
+     * @brief Record the data of the graph, then draw it unless in retained mode.
+     * @param draw Function drawing the data.
+     * @param x_data Values of the x-axis, NULL if none.
+     * @param y_data Values of the y-axis.
+     * @param n_data Number of data points, nothing is recorded if 0.
+     * @param min_Y Lower limit of the y-axis, NULL to take the lowest value.
+     * @param max_Y Upper limit of the y-axis, NULL to take the highest value.
+     * @param size Size of the limits in bytes.
+     * @param labels Labels of the PIE slices, NULL if none.
+     * @param scan Whether to widen the limits to the data, false to use them as they are.
+     * @param n_series Number of series pointed by y_data, 0 if y_data is a single series.
+     * @param stacked Whether the series of bars are stacked.
      */
-    void drawLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t y_limit);
+    void setData(void (*draw)(Graph_TFT &, const GRAPH_DATA &), const void *x_data, const void *y_data, uint32_t n_data,
+                 const void *min_Y, const void *max_Y, size_t size, const char **labels = NULL, bool scan = true,
+                 uint8_t n_series = 0, bool stacked = false);
 
     /**
-     * @brief Find the maximum value in the y-axis data.
-     * @param y_data Array of y-axis data points.
+     * @brief Get the limits of the y-axis of the recorded data, shared by all of its series.
+     */
+    template <typename T, typename I>
+    void limits(const GRAPH_DATA &data, const T *const *series, uint8_t n_series, I n_data, T &min_Y, T &max_Y);
+
+    /**
+     * @brief Get the range of the data in one pass over every series, widened to the given limits.
+     *
+     * Stacked series range from 0 (or their lowest value) to their highest total.
+     */
+    template <typename T, typename I>
+    static void scanLimits(const GRAPH_DATA &data, const T *const *series, uint8_t n_series, I n_data, T &min_Y, T &max_Y);
+
+    /**
+     * @brief Get the series of recorded data, a single series being an array of one.
+     */
+    template <typename T>
+    static const T *const *getSeries(const GRAPH_DATA &data, const T *&single, uint8_t &n_series);
+
+    /**
+     * @brief Turn the range of the data into the NICE y-axis, with hysteresis.
+     * @param min_Y Lowest value in, lower limit of the axis out.
+     * @param max_Y Highest value in, upper limit of the axis out.
+     * @param integral Whether the data is integral, the tick is then at least 1.
+     */
+    void autoscale(double &min_Y, double &max_Y, bool integral);
+
+    /**
+     * @brief Draw recorded bars, lines or PIE.
+     */
+    template <class G, typename T, typename I>
+    static void renderBARS(Graph_TFT &graph, const GRAPH_DATA &data);
+    template <class G, typename X, typename Y, typename I>
+    static void renderLINES(Graph_TFT &graph, const GRAPH_DATA &data);
+    template <typename T>
+    static void renderPIE(Graph_TFT &graph, const GRAPH_DATA &data);
+    template <typename X, typename Y, typename I>
+    static void renderSCATTER(Graph_TFT &graph, const GRAPH_DATA &data);
+
+    /**
+     * @brief Find the minimum and the maximum values of the data in one pass.
+     * @param y_data Array of data points.
      * @param n_data Number of data points.
-     * @param max true to get the max value, false to get the min value
-     * @return Maximum value in the data array.
+     * @param min Minimum value, 0 if there is no data.
+     * @param max Maximum value, 0 if there is no data.
      */
-    uint16_t maxminValue(uint16_t *y_data, uint8_t n_data, bool max);
+    template <typename T, typename I>
+    static void minmaxValue(const T *y_data, I n_data, T &min, T &max);
 
     /**
      * @brief Ordena el arreglo `arrX` y, si está presente, el arreglo `arrY` usando el algoritmo Quicksort.
@@ -169,7 +659,8 @@ private:
      * @param left Índice de la posición izquierda del arreglo.
      * @param right Índice de la posición derecha del arreglo.
      */
-    void quickSortX(uint16_t *arrX, uint16_t *arrY, uint8_t left, uint8_t right);
+    template <typename X, typename Y>
+    void quickSortX(X *arrX, Y *arrY, int32_t left, int32_t right);
 
     /**
      * @brief Particiona el arreglo `arrX` y, si está presente, también el arreglo `arrY` alrededor de un pivote.
@@ -184,7 +675,8 @@ private:
      * @param right Índice de la posición derecha del arreglo.
      * @return El índice final del pivote.
      */
-    uint8_t partition(uint16_t *arrX, uint16_t *arrY, uint8_t left, uint8_t right);
+    template <typename X, typename Y>
+    int32_t partition(X *arrX, Y *arrY, int32_t left, int32_t right);
 
     /**
      * @brief Intercambia los valores de dos variables.
@@ -194,10 +686,41 @@ private:
      * @param a Puntero a la primera variable.
      * @param b Puntero a la segunda variable.
      */
-    void swap(uint16_t *a, uint16_t *b);
+    template <typename T>
+    void swap(T *a, T *b);
+
 
+protected:
+    /**
+     * @brief Ignore the style setters from now on, the colours being constants of the type.
+     */
+    void lockStyle(void) { styleLocked = true; }
 
 public:
+    /**
+     * @brief Constructor for the Graph_TFT class with individual parameters.
+     * @param target Pointer to the drawing target.
+     * @param x X-coordinate of the canvas starting point from Top-Left.
+     * @param y Y-coordinate of the canvas starting point from Top-Left.
+     * @param width Width of the graph (default is CANVAS_WIDTH).
+     * @param height Height of the graph (default is CANVAS_HEIGHT).
+     * @param padding Padding around the graph (default is DEFAULT_PADDING).
+     * @param rounded Rounded corners for the graph (default is DEFAULT_ROUNDED).
+     * @param type Type of the graph (default is BARS).
+     * @param style Style of the graph (default is BLACK).
+     */
+    Graph_TFT(Graph_Target *target, uint16_t x, uint16_t y, uint16_t width = CANVAS_WIDTH, uint16_t height = CANVAS_HEIGHT, uint8_t padding = DEFAULT_PADDING, uint8_t rounded = DEFAULT_ROUNDED, GRAPH_STYLE style = BLACK);
+
+    /**
+     * @brief Constructor for the Graph_TFT class using a CANVA_STYLE structure.
+     * @param target Pointer to the drawing target.
+     * @param canva_style Structure containing canvas styling options.
+     * @param type Type of the graph (default is BARS).
+     * @param style Style of the graph (default is BLACK).
+     */
+    Graph_TFT(Graph_Target *target, CANVA_STYLE canva_style, GRAPH_STYLE style = BLACK);
+
+#ifdef ARDUINO
     /**
      * @brief Constructor for the Graph_TFT class with individual parameters.
      * @param display Pointer to the TFT display object.
@@ -220,15 +743,24 @@ public:
      * @param style Style of the graph (default is BLACK).
      */
     Graph_TFT(TFT_eSPI *display, CANVA_STYLE canva_style, GRAPH_STYLE style = BLACK);
+#endif
+
+    Graph_TFT(const Graph_TFT &) = delete;
+    Graph_TFT &operator=(const Graph_TFT &) = delete;
 
     /**
      * @brief Set the data and limits for bar graphs.
+     *
+     * The samples can be of any integer or floating point type and any count, they are read in place.
+     * The geometry G of the renderer is read from the canvas (Graph_Geometry) unless a
+     * Graph_TFT_Fixed gives its constants.
      * @param y_data Array of y-axis data points.
      * @param n_data Number of data points.
      * @param min_Y Minimun value for y-axis scaling.
      * @param max_Y Maximum value for y-axis scaling.
      */
-    void setDataBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y);
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y);
 
     /**
      * @brief Set the data for bar graphs, y-axis scaling max with y-max.
@@ -236,24 +768,39 @@ public:
      * @param n_data Number of data points.
      * @param min_Y Minimun value for y-axis scaling.
      */
-    void setDataBARS(uint16_t *y_data, uint8_t n_data, uint16_t min_Y);
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y);
 
     /**
      * @brief Set the data for bar graphs, y-axis scaling with y-max - y-min.
      * @param y_data Array of y-axis data points.
      * @param n_data Number of data points.
      */
-    void setDataBARS(uint16_t *y_data, uint8_t n_data);
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *y_data, I n_data);
+
+    /**
+     * @brief Set the data for bar graphs, y-axis scaling with the range of a window, without scanning the data.
+     * @param y_data Array of y-axis data points.
+     * @param n_data Number of data points.
+     * @param window Window holding the data points (values outside of its range are clamped).
+     */
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *y_data, I n_data, const Graph_Window<T> &window);
 
     /**
      * @brief Set the data and limits for lines graph.
+     *
+     * The samples can be of any integer or floating point type and any count. They are read in
+     * place, only unsorted x_data is copied to be sorted.
      * @param x_data Array of x-axis data points.
      * @param y_data Array of y-axis data points.
      * @param n_data Number of data points.
      * @param min_Y Minimun value for y-axis scaling.
      * @param max_Y Maximum value for y-axis scaling.
      */
-    void setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y, uint16_t max_Y);
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y);
 
     /**
      * @brief Set the data and limits for lines graph, y-axis scaling max with y-max.
@@ -262,7 +809,8 @@ public:
      * @param n_data Number of data points.
      * @param min_Y Maximum value for y-axis scaling.
      */
-    void setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data, uint16_t min_Y);
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y);
 
     /**
      * @brief Set the data for lines graph, y-axis scaling with y-max y y-min.
@@ -270,7 +818,110 @@ public:
      * @param y_data Array of y-axis data points.
      * @param n_data Number of data points.
      */
-    void setDataLINES(uint16_t *x_data, uint16_t *y_data, uint8_t n_data);
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data);
+
+    /**
+     * @brief Set the data for lines graph, y-axis scaling with the range of a window, without scanning the data.
+     * @param x_data Array of x-axis data points.
+     * @param y_data Array of y-axis data points.
+     * @param n_data Number of data points.
+     * @param window Window holding the y-axis data points (values outside of its range are clamped).
+     */
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, const Graph_Window<Y> &window);
+
+    /**
+     * @brief Set several series of bars sharing the axes, coloured from the palette (setPalette).
+     *
+     * The y-axis spans every series, found in one pass over all of them. The background, axis
+     * and labels are drawn once for all series.
+     * @param series Array of n_series arrays of y-axis data points, kept by reference.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     * @param layout GROUPED (default) or STACKED, stacked series only add their positive values.
+     */
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout = GROUPED);
+
+    /**
+     * @brief Set several series of bars sharing the axes, with limits.
+     * @param series Array of n_series arrays of y-axis data points, kept by reference.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     * @param layout GROUPED or STACKED.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     */
+    template <typename T, typename I, class G = Graph_Geometry>
+    void setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y);
+
+    /**
+     * @brief Set several series of lines sharing the x-axis data and the axes, coloured from the palette.
+     *
+     * The y-axis spans every series, found in one pass over all of them. The background, axis
+     * and labels are drawn once for all series. Unsorted x_data needs GRAPH_SCRATCH_SERIES bytes
+     * of scratch memory.
+     * @param x_data Array of x-axis data points, shared by the series.
+     * @param series Array of n_series arrays of y-axis data points, kept by reference.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     */
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data);
+
+    /**
+     * @brief Set several series of lines sharing the x-axis data and the axes, with limits.
+     * @param x_data Array of x-axis data points, shared by the series.
+     * @param series Array of n_series arrays of y-axis data points, kept by reference.
+     * @param n_series Number of series.
+     * @param n_data Number of data points of every series.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     */
+    template <typename X, typename Y, typename I, class G = Graph_Geometry>
+    void setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y);
+
+    /**
+     * @brief Set the data for scatter graph, axes scaling with the range of the data.
+     *
+     * Made for large point clouds: each point stamps a pre-rasterized marker (setMarker), and
+     * with GRAPH_SCRATCH_SCATTER bytes of scratch memory an occupancy bitmap makes every point
+     * landing on a px already stamped free, so a frame costs at most one stamp per px of the plot.
+     * The x-axis has no labels.
+     * @param x_data Array of x-axis data points.
+     * @param y_data Array of y-axis data points.
+     * @param n_data Number of data points.
+     */
+    template <typename X, typename Y, typename I>
+    void setDataSCATTER(const X *x_data, const Y *y_data, I n_data);
+
+    /**
+     * @brief Set the data and y-axis limits for scatter graph.
+     * @param x_data Array of x-axis data points.
+     * @param y_data Array of y-axis data points.
+     * @param n_data Number of data points.
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     */
+    template <typename X, typename Y, typename I>
+    void setDataSCATTER(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y);
+
+    /**
+     * @brief Set the marker of the scatter graphs.
+     * @param shape DOT (default), PLUS, SQUARE or DISC.
+     */
+    void setMarker(GRAPH_MARKER shape);
+
+    /**
+     * @brief Colour the scatter points by the number of points landing on their px.
+     *
+     * Needs GRAPH_SCRATCH_DENSITY bytes of scratch memory to count the points, otherwise the
+     * points keep the secondary colour.
+     * @param lut RGB565 colours from the sparsest to the densest px, kept by reference (see graphHeatLUT), NULL to disable.
+     * @param size Number of colours.
+     */
+    void setDensity(const uint16_t *lut, uint16_t size);
 
     /**
      * @brief Set the data for PIE graph
@@ -287,6 +938,151 @@ public:
      */
     void setDataPIE(uint8_t *percentage, uint8_t n_data, const char *labels[]);
 
+    /**
+     * @brief Set the data for PIE graph, with sub-percent resolution.
+     * @param values Value of every data, the slices are proportional to their total.
+     * @param n_data Number of data.
+     */
+    void setDataPIE(uint16_t *values, uint8_t n_data);
+
+    /**
+     * @brief Set the data for PIE graph, with sub-percent resolution.
+     * @param values Value of every data, the slices are proportional to their total.
+     * @param n_data Number of data.
+     * @param labels Labels for each data.
+     */
+    void setDataPIE(uint16_t *values, uint8_t n_data, const char *labels[]);
+
+    /**
+     * @brief Set the colours of the PIE slices and of the series of multi-series graphs, used cyclically.
+     * @param colors Array of RGB565 colours, kept by reference (NULL for the default palette).
+     * @param n_colors Number of colours.
+     */
+    void setPalette(const uint16_t *colors, uint8_t n_colors);
+
+    /**
+     * @brief Start a streaming line graph (strip chart), fed one sample at a time with appendSample.
+     *
+     * Each sample takes one px column. In framebuffer mode the plot scrolls to the left, otherwise
+     * a cursor sweeps the plot and wraps around (no hardware scroll is available on every panel).
+     * @param buffer Storage for the history of samples.
+     * @param capacity Number of samples of the history (the plot shows up to getWidth() of them).
+     * @param min_Y Minimun value for y-axis scaling.
+     * @param max_Y Maximum value for y-axis scaling.
+     */
+    void setStream(uint16_t *buffer, uint16_t capacity, uint16_t min_Y, uint16_t max_Y);
+
+    /**
+     * @brief Start a streaming line graph whose y-axis follows the range of the last samples.
+     *
+     * The samples are also pushed into the window, whose min and max give the y-axis in O(1) per
+     * sample. The plot is redrawn whole when that range changes.
+     * @param buffer Storage for the history of samples.
+     * @param capacity Number of samples of the history.
+     * @param window Window of the samples setting the range, usually as wide as the plot.
+     */
+    void setStream(uint16_t *buffer, uint16_t capacity, Graph_Window<uint16_t> *window);
+
+    /**
+     * @brief Append a sample to the streaming line graph.
+     *
+     * Only the newest segment is drawn, so the cost is constant whatever the length of the history.
+     * @param value Sample value.
+     */
+    void appendSample(uint16_t value);
+
+    /**
+     * @brief Append several samples to the streaming line graph, drawn in one frame.
+     * @param values Sample values.
+     * @param n Number of samples.
+     */
+    void appendSamples(const uint16_t *values, uint16_t n);
+
+    /**
+     * @brief Append the samples waiting in a queue to the streaming line graph, drawn in one frame.
+     *
+     * The consumer side of a producer/renderer split: a sampling task or ISR pushes into the
+     * queue, possibly on the other core, while the render task calls drainSamples. Only the
+     * samples queued when the call starts are taken.
+     * @param queue Queue filled by the producer.
+     * @return Number of samples appended.
+     */
+    uint32_t drainSamples(Graph_Queue<uint16_t> &queue);
+
+    /**
+     * @brief Start a heatmap (spectrogram), fed one column of bins at a time with appendSpectrum.
+     *
+     * Each spectrum takes one px column, the first bin at the bottom, coloured through a
+     * precomputed palette. In framebuffer mode the plot scrolls to the left, otherwise a cursor
+     * sweeps the plot. A column is drawn as one block from GRAPH_SCRATCH_HEATMAP(getHeight())
+     * bytes of scratch memory, or as runs of one colour without it.
+     * @param buffer Storage for capacity * bins levels.
+     * @param capacity Number of columns of the history (the plot shows up to getWidth() of them).
+     * @param bins Number of bins of a spectrum.
+     * @param lut RGB565 palette from the lowest to the highest value, kept by reference (see graphHeatLUT).
+     * @param lutSize Number of colours of the palette, up to GRAPH_HEAT_LEVELS.
+     */
+    void setHeatmap(uint8_t *buffer, uint16_t capacity, uint16_t bins, const uint16_t *lut, uint16_t lutSize);
+
+    /**
+     * @brief Append a spectrum to the heatmap.
+     *
+     * Only the new column is drawn, a single block write whatever the length of the history.
+     * @param values Value of every bin.
+     * @param min_Y Value of the first colour of the palette, lower values are clamped.
+     * @param max_Y Value of the last colour of the palette, higher values are clamped.
+     */
+    template <typename T>
+    void appendSpectrum(const T *values, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y);
+
+    /**
+     * @brief Supply the scratch memory of the renders, no render ever allocates from the heap.
+     *
+     * Only setDataLINES with unsorted x_data needs it, GRAPH_SCRATCH_LINES bytes to sort a copy of
+     * the points (GRAPH_SCRATCH_SERIES with several series). Without enough scratch the points are walked in x order in O(n^2), and unsorted
+     * series with more points than px columns are not drawn.
+     * @param buffer Scratch memory, kept by reference (NULL for none).
+     * @param size Size of the scratch memory in bytes.
+     */
+    void setScratch(void *buffer, size_t size);
+
+    /**
+     * @brief Get the highest amount of scratch memory used by a render so far, in bytes.
+     */
+    size_t getScratchPeak(void) const { return scratch.getPeak(); }
+
+#if GRAPH_ENABLE_STATS
+    /**
+     * @brief Get the render statistics: per-phase cost of the last frame and running min/avg/max.
+     *
+     * Only available when built with GRAPH_ENABLE_STATS=1, otherwise the instrumentation is compiled out.
+     */
+    const GRAPH_STATS &getStats(void) const { return stats.get(); }
+
+    /**
+     * @brief Clear the render statistics.
+     */
+    void resetStats(void) { stats.reset(); }
+#endif
+
+    /**
+     * @brief Set how lines with more points than px columns are decimated.
+     *
+     * Bars always keep the highest point of each column.
+     * @param mode MINMAX (default) or LTTB.
+     */
+    void setDecimation(GRAPH_DECIMATION mode);
+
+    /**
+     * @brief Set how the y-axis follows data given without limits (and autoscaled streams).
+     *
+     * NICE keeps the y-axis on multiples of a 1/2/5 x 10^k tick, labelled at every tick. It grows
+     * as soon as the data leaves it and shrinks once the data stayed within half of it for
+     * GRAPH_AUTOSCALE_HOLD frames, so most frames keep the axis and can be drawn incrementally.
+     * @param mode EXACT (default) or NICE.
+     */
+    void setAutoscale(GRAPH_AUTOSCALE mode);
+
     /**
      * @brief Set the number of axis divisions for labels.
      * @param divX Number of divisions for the X axis.
@@ -294,9 +1090,140 @@ public:
      */
     void setAxisDiv(uint8_t divX, uint8_t divY);
 
+    /**
+     * @brief Compose every frame off-screen and push it to the panel with a single block write.
+     *
+     * Removes the flicker of drawing the background, axis and data directly on the panel and
+     * sends each canvas pixel exactly once per frame.
+     * @param buffer RGB565 buffer of getWidth() * getHeight() pixels, or NULL to draw directly on the panel.
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     */
+    void setFramebuffer(uint16_t *buffer, uint16_t RGB565 = COLOR_BLACK);
+
+    /**
+     * @brief Compose the frames in two buffers and send them to the panel asynchronously (DMA).
+     *
+     * While a frame is being sent from one buffer, the next one is composed in the other. Only the
+     * rows changed by a frame are sent. On TFT_eSPI panels call initDMA() first and use DMA capable
+     * memory, otherwise the frames are pushed synchronously. The framebuffers must never be written
+     * by the transfer, yet TFT_eSPI swaps the bytes of a DMA image in place after setSwapBytes(true):
+     * with swapped bytes, give a DMA capable bounce buffer the frames are copied to and swapped in,
+     * or the frames are pushed synchronously.
+     * @param buffer RGB565 buffer of getWidth() * getHeight() pixels, or NULL to draw directly on the panel.
+     * @param second Second buffer of the same size, or NULL for synchronous pushes (as setFramebuffer).
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     * @param bounce DMA bounce buffer of getWidth() * getHeight() pixels, needed with swapped bytes (NULL for none).
+     */
+    void setAsyncFramebuffers(uint16_t *buffer, uint16_t *second, uint16_t RGB565 = COLOR_BLACK, uint16_t *bounce = NULL);
+
+    /**
+     * @brief Compose every frame in a palette indexed framebuffer, expanded to RGB565 while pushed.
+     *
+     * A 4 bpp buffer takes a quarter of the memory of a RGB565 one, 8 bpp half of it. Every full
+     * redraw starts the palette over with the colours of the style: background, primary, secondary,
+     * then the PIE and series colours. Other colours are added while there is room and take the
+     * closest entry afterwards. Frames are pushed synchronously.
+     * @param buffer Buffer of GRAPH_INDEXED_BYTES(getWidth(), getHeight(), bpp) bytes, or NULL to draw directly on the panel.
+     * @param bpp Bits per pixel, 4 (16 colours) or 8 (256 colours).
+     * @param palette Storage for the 16 or 256 RGB565 colours of the palette.
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     */
+    void setIndexedFramebuffer(uint8_t *buffer, uint8_t bpp, uint16_t *palette, uint16_t RGB565 = COLOR_BLACK);
+
+    /**
+     * @brief Record every frame as a display list and only redraw what changed since the last one.
+     *
+     * Each frame is recorded in full, whatever it changed, then compared with the frame on screen:
+     * the calls gone or new give a few rectangles, where the frame is rasterized again in bands of
+     * the scratch memory (setScratch, at least getWidth() * 2 bytes) and pushed. A moved vertex or
+     * a changed PIE slice only costs its bounding box. The framebuffer is dropped. A frame with
+     * more calls than the capacity, or without scratch memory, is drawn directly on the panel.
+     * @param commands Storage for two lists of capacity commands, or NULL to stop recording.
+     * @param capacity Maximum number of drawing calls of a frame.
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     */
+    void setDisplayList(GRAPH_COMMAND *commands, uint16_t capacity, uint16_t RGB565 = COLOR_BLACK);
+
+    /**
+     * @brief Rasterize every frame in horizontal strips of the canvas, through a buffer of a few rows.
+     *
+     * The graph is drawn once per strip into the buffer, every primitive being clipped to it, and
+     * each strip is pushed in a single address window as soon as it is complete. The panel only
+     * receives finished pixels, once per frame, like with a framebuffer but for getWidth() * rows
+     * pixels of RAM (10 KB for 16 rows of a 320 px canvas). The framebuffer is dropped. With a
+     * display list (setDisplayList), only the changed areas are rasterized, through this buffer.
+     * @param buffer Buffer of getWidth() * rows RGB565 pixels, or NULL to stop rasterizing in strips.
+     * @param rows Rows per strip, the taller the fewer passes over the graph.
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     */
+    void setStripBuffer(uint16_t *buffer, uint16_t rows, uint16_t RGB565 = COLOR_BLACK);
+
+    /**
+     * @brief Check whether a frame is still being sent to the panel.
+     */
+    bool isPresenting(void) { return panel->busy(); }
+
+    /**
+     * @brief Wait until the last frame has been sent to the panel.
+     */
+    void waitPresent(void) { panel->wait(); }
+
+    /**
+     * @brief Switch between immediate mode (default) and retained mode.
+     *
+     * In immediate mode the data setters and setTitle draw at once. In retained mode every setter
+     * only records the change and render() or update() draws them all in one frame, so a burst of
+     * changes costs a single frame and the colour setters take effect like the others. The data
+     * arrays are kept by reference until they are drawn.
+     * @param enable true for retained mode.
+     */
+    void setRetained(bool enable);
+
+    /**
+     * @brief Draw the changes recorded since the last frame, if any.
+     * @return true if a frame was drawn.
+     */
+    bool render(void);
+
+    /**
+     * @brief Draw the changes recorded since the last frame, unless the frame rate cap is reached.
+     * @param now Current time in microseconds (graphMicros()).
+     * @return true if a frame was drawn.
+     */
+    bool update(uint32_t now);
+
+    /**
+     * @brief Cap the frames drawn by update.
+     * @param fps Maximum frames per second, 0 for no cap.
+     */
+    void setFrameRate(uint16_t fps);
+
+    /**
+     * @brief Check whether changes are waiting to be drawn by render.
+     */
+    bool isDirty(void) const { return dirtyStatic || dirtyData || pendingSamples > 0; }
+
+    /**
+     * @brief Get the traffic counters of the panel the graph draws to.
+     */
+    const GRAPH_COUNTERS &getPanelCounters(void) const { return panel->getCounters(); }
+
+    /**
+     * @brief Cache the static layer of the graph (background, frame, axis and title) in a buffer.
+     *
+     * The layer is rasterized once and copied in one block at the start of every frame. It is
+     * rebuilt after setStyle, setTitle, setAxis, setAxisDiv and the colour setters, and when the
+     * range of the axis labels changes. Labels are then drawn under the data.
+     * @param buffer RGB565 buffer of getWidth() * getHeight() pixels, or NULL to draw the layer every frame.
+     * @param RGB565 Colour of the screen behind the rounded corners of the canvas (default is COLOR_BLACK).
+     */
+    void setStaticLayer(uint16_t *buffer, uint16_t RGB565 = COLOR_BLACK);
+
     /**
      * @brief Set the style of the graph.
      * @param style The desired graph style.
+     *
+     * Ignored by a Graph_TFT_Fixed, whose style is fixed.
      */
     void setStyle(GRAPH_STYLE style);
 
@@ -309,18 +1236,24 @@ public:
     /**
      * @brief Set the background color of the graph.
      * @param RGB565 The color in RGB565 format.
+     *
+     * Ignored by a Graph_TFT_Fixed, whose style is fixed.
      */
     void setBackgroudColour(uint16_t RGB565);
 
     /**
      * @brief Set the primary drawing color for the graph elements.
      * @param RGB565 The color in RGB565 format.
+     *
+     * Ignored by a Graph_TFT_Fixed, whose style is fixed.
      */
     void setDrawingPrimaryColour(uint16_t RGB565);
 
     /**
      * @brief Set the secondary drawing color for the graph elements.
      * @param RGB565 The color in RGB565 format.
+     *
+     * Ignored by a Graph_TFT_Fixed, whose style is fixed.
      */
     void setDrawingSecondaryColour(uint16_t RGB565);
 
@@ -343,3 +1276,5 @@ public:
      */
     uint16_t getHeight(void);
 };
+
+#include "Graph_TFT.tpp"
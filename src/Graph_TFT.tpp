@@ -0,0 +1,804 @@
+/*
+ * Template members of Graph_TFT, included from Graph_TFT.h.
+ */
+#include <string.h>
+#include <limits>
+
+template <class G, typename T, typename I>
+void Graph_TFT::drawBARS(const T *const *series, uint8_t n_series, I n_data, T min_Y, T max_Y, bool stacked)
+{
+    const G geo(graphW, graphH, canva_style);
+    uint32_t n = n_data;
+    if (n_series == 1 && barCount == n && barMinY == (double)min_Y && barMaxY == (double)max_Y)
+    {
+        updateBARS<G>(series[0], n_data, min_Y, max_Y);
+        return;
+    }
+
+    invalidate();
+
+    if (!(max_Y > min_Y))
+    {
+        drawStatic(true);
+        return;
+    }
+
+    stacked = stacked && n_series > 1;
+    int32_t deltaX_px = ((int32_t)geo.graphW() - ((int32_t)n + 1)) / (int32_t)n;
+    int32_t barW = stacked ? deltaX_px : deltaX_px / n_series; // width of a bar within a group
+
+    if (barW < 1)
+    {
+        // More bars than px columns, each column shows the highest of its bars (the extremes of each series)
+        GRAPH_LABELS labels = {0, (long)min_Y, (long)max_Y, 1, 0, labelStepY};
+        if (deltaX_px > 0)
+        {
+            labels.deltaX_px = deltaX_px;
+            labels.max_X = n;
+        }
+        drawStatic(true, &labels);
+        for (uint8_t s = 0; s < n_series; s++)
+        {
+            drawMinMax<G>(series[s], n, min_Y, max_Y, startX + 2, geo.graphW() - 2, n_series == 1, seriesColor(s, n_series));
+        }
+        drawLabels(labels);
+        return;
+    }
+
+    GRAPH_LABELS labels = {(uint16_t)deltaX_px, (long)min_Y, (long)max_Y, 1, (long)n, labelStepY};
+    drawStatic(true, &labels);
+
+    int32_t x = 2 + startX;
+    int32_t barHeight = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        // Stacked segments go from the total of the series below to the total including their own
+        double total = 0;
+        int32_t bottom = Graph_Scale<double>::map(0, min_Y, max_Y, geo.graphH());
+        for (uint8_t s = 0; s < n_series; s++)
+        {
+            uint16_t color = seriesColor(s, n_series);
+            int32_t barX = x;
+            if (stacked)
+            {
+                total += (series[s][i] > T()) ? (double)series[s][i] : 0;
+                barHeight = Graph_Scale<double>::map(total, min_Y, max_Y, geo.graphH()) - bottom;
+                bottom += barHeight;
+            }
+            else
+            {
+                barHeight = Graph_Scale<T>::map(series[s][i], min_Y, max_Y, geo.graphH());
+                bottom = barHeight;
+                barX += s * barW;
+            }
+
+            if (n_series == 1 && i < GRAPH_MAX_BARS)
+            {
+                barHeights[i] = barHeight;
+            }
+
+            if (barHeight < 1 && n_series > 1)
+                continue;
+
+            if (geo.fill())
+            {
+                tft->fillRect(barX, startY - bottom, barW, barHeight, color);
+            }
+            else
+            {
+                tft->drawRect(barX, startY - bottom, barW, barHeight, color);
+            }
+        }
+
+        x += deltaX_px + 1; // span 1 px between bars
+    }
+
+    drawLabels(labels);
+
+    if (n_series == 1 && n <= GRAPH_MAX_BARS)
+    {
+        barCount = n;
+        barMinY = min_Y;
+        barMaxY = max_Y;
+    }
+}
+
+template <class G, typename T, typename I>
+void Graph_TFT::updateBARS(const T *y_data, I n_data, T min_Y, T max_Y)
+{
+    const G geo(graphW, graphH, canva_style);
+    uint32_t n = n_data;
+    int32_t barW = ((int32_t)geo.graphW() - ((int32_t)n + 1)) / (int32_t)n;
+
+    // Only the changed rows are pushed, unchanged bars cost nothing
+    fullFrame = false;
+
+    int32_t x = 2 + startX;
+    for (uint32_t i = 0; i < n; i++, x += barW + 1)
+    {
+        uint16_t oldH = barHeights[i];
+        uint16_t newH = Graph_Scale<T>::map(y_data[i], min_Y, max_Y, geo.graphH());
+        if (newH == oldH)
+            continue;
+
+        uint16_t top = startY - ((newH > oldH) ? newH : oldH);
+        uint16_t rows = (newH > oldH) ? newH - oldH : oldH - newH;
+
+        if (geo.fill())
+        {
+            tft->fillRect(x, top, barW, rows, (newH > oldH) ? geo.draw2() : geo.background());
+            pushRect(x, top, barW, rows);
+        }
+        else if (oldH < 2 || newH < 2)
+        {
+            // Degenerated outlines are drawn over the axis, redraw the whole bar
+            rows = startY - top;
+            tft->fillRect(x, top, barW, rows, geo.background());
+            tft->drawFastHLine(x, startY, barW, geo.draw1());
+            tft->drawRect(x, startY - newH, barW, newH, geo.draw2());
+            pushRect(x, top, barW, rows + 1);
+        }
+        else if (newH > oldH)
+        {
+            // Open the old top edge and extend the sides
+            tft->drawFastHLine(x + 1, startY - oldH, barW - 2, geo.background());
+            tft->drawFastVLine(x, top, rows, geo.draw2());
+            tft->drawFastVLine(x + barW - 1, top, rows, geo.draw2());
+            tft->drawFastHLine(x, top, barW, geo.draw2());
+            pushRect(x, top, barW, rows + 1);
+        }
+        else
+        {
+            // Erase the top of the bar and close it at the new height
+            tft->fillRect(x, top, barW, rows, geo.background());
+            tft->drawFastHLine(x, startY - newH, barW, geo.draw2());
+            pushRect(x, top, barW, rows + 1);
+        }
+
+        barHeights[i] = newH;
+    }
+}
+
+template <class G, typename X, typename Y, typename I>
+void Graph_TFT::drawLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data, Y min_Y, Y max_Y)
+{
+    const G geo(graphW, graphH, canva_style);
+    uint32_t n = n_data;
+
+    invalidate();
+
+    if (!(max_Y > min_Y))
+    {
+        drawStatic(true);
+        return;
+    }
+
+    // Same spacing as the bars, or decimated to the px columns when the points don't fit
+    int32_t step = ((int32_t)geo.graphW() - 1) / (int32_t)n;
+
+    // Points are joined in x order, only unsorted data is copied to the scratch memory to be sorted
+    size_t mark = scratch.mark();
+    const Y *first = series[0];
+    const uint32_t *order = NULL; // x order of the points, when several series share a sorted copy of x_data
+    Y *ordered = NULL;            // series being drawn, copied in x order
+    bool sorted = graphIsSorted(x_data, n);
+    if (!sorted && n_series == 1)
+    {
+        X *x_data_sorted = scratch.alloc<X>(n);
+        Y *y_data_sorted = scratch.alloc<Y>(n);
+        if (x_data_sorted != NULL && y_data_sorted != NULL)
+        {
+            memcpy(x_data_sorted, x_data, n * sizeof(X));
+            memcpy(y_data_sorted, first, n * sizeof(Y));
+
+            quickSortX(x_data_sorted, y_data_sorted, 0, n - 1);
+            x_data = x_data_sorted;
+            first = y_data_sorted;
+            sorted = true;
+        }
+    }
+    else if (!sorted)
+    {
+        // Several series: sort x_data with the index of each point, then copy each series in that order
+        X *x_data_sorted = scratch.alloc<X>(n);
+        uint32_t *index = scratch.alloc<uint32_t>(n);
+        ordered = scratch.alloc<Y>(n);
+        if (x_data_sorted != NULL && index != NULL && ordered != NULL)
+        {
+            memcpy(x_data_sorted, x_data, n * sizeof(X));
+            for (uint32_t i = 0; i < n; i++)
+            {
+                index[i] = i;
+            }
+
+            quickSortX(x_data_sorted, index, 0, n - 1);
+            x_data = x_data_sorted;
+            order = index;
+            sorted = true;
+        }
+    }
+    if (!sorted && step == 0)
+    {
+        drawStatic(true);
+        scratch.release(mark);
+        return;
+    }
+
+    X min_X = x_data[0], max_X = x_data[n - 1];
+    if (!sorted)
+    {
+        minmaxValue(x_data, n, min_X, max_X);
+    }
+
+    GRAPH_LABELS labels = {0, (long)min_Y, (long)max_Y, 1, 0, labelStepY};
+    if (step > 0)
+    {
+        labels.deltaX_px = step - 1;
+        labels.min_X = (long)min_X;
+        labels.max_X = (long)max_X;
+    }
+    drawStatic(true, &labels);
+
+    for (uint8_t s = 0; s < n_series; s++)
+    {
+        uint16_t color = seriesColor(s, n_series);
+        const Y *y_data = (s == 0) ? first : series[s];
+        if (order != NULL)
+        {
+            for (uint32_t i = 0; i < n; i++)
+            {
+                ordered[i] = y_data[order[i]];
+            }
+            y_data = ordered;
+        }
+
+        if (step == 0 && decimation == LTTB)
+        {
+            drawLTTB<G>(y_data, n, min_Y, max_Y, startX + 1, geo.graphW() - 1, color);
+        }
+        else if (step == 0)
+        {
+            drawMinMax<G>(y_data, n, min_Y, max_Y, startX + 1, geo.graphW() - 1, false, color);
+        }
+
+        int32_t xs = 0, ys = 0;
+        uint32_t k = n;
+        for (uint32_t i = 0; i < n && step > 0; i++)
+        {
+            // Without scratch memory the points are walked in x order in place
+            k = sorted ? i : graphNextInOrder(x_data, n, k);
+
+            int32_t xe = startX + 1 + (step - 1) / 2 + (int32_t)i * step;
+            int32_t ye = startY - Graph_Scale<Y>::map(y_data[k], min_Y, max_Y, geo.graphH());
+
+            if (i > 0)
+            {
+                tft->drawLine(xs, ys, xe, ye, color);
+            }
+
+            if (geo.fill())
+            {
+                tft->fillCircle(xe, ye, 2, color);
+            }
+            else
+            {
+                tft->drawCircle(xe, ye, 2, color);
+            }
+
+            xs = xe;
+            ys = ye;
+        }
+    }
+
+    drawLabels(labels);
+
+    scratch.release(mark);
+}
+
+template <typename X, typename Y, typename I>
+void Graph_TFT::drawSCATTER(const X *x_data, const Y *y_data, I n_data, X min_X, X max_X, Y min_Y, Y max_Y)
+{
+    uint32_t n = n_data;
+
+    invalidate();
+
+    GRAPH_LABELS labels = {0, (long)min_Y, (long)max_Y, 1, 0, labelStepY};
+    drawStatic(true, &labels);
+
+    uint16_t plotX = startX + 2;
+    uint16_t plotW = graphW - 2;
+    size_t cells = (size_t)plotW * graphH;
+
+    // Occupancy bitmap, or one count per px to colour by density
+    size_t mark = scratch.mark();
+    uint8_t *counts = (densityLUT != NULL) ? scratch.alloc<uint8_t>(cells) : NULL;
+    uint8_t *occupied = (counts == NULL) ? scratch.alloc<uint8_t>((cells + 7) / 8) : NULL;
+    if (counts != NULL)
+    {
+        memset(counts, 0, cells);
+    }
+    if (occupied != NULL)
+    {
+        memset(occupied, 0, (cells + 7) / 8);
+    }
+
+    uint8_t densest = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int32_t col = Graph_Scale<X>::map(x_data[i], min_X, max_X, plotW - 1);
+        int32_t row = graphH - 1 - Graph_Scale<Y>::map(y_data[i], min_Y, max_Y, graphH - 1);
+        size_t cell = (size_t)row * plotW + col;
+
+        if (counts != NULL)
+        {
+            counts[cell] += (counts[cell] < 255);
+            densest = (counts[cell] > densest) ? counts[cell] : densest;
+            continue;
+        }
+        if (occupied != NULL)
+        {
+            // A px already stamped costs nothing more
+            uint8_t bit = 1 << (cell & 7);
+            if (occupied[cell >> 3] & bit)
+                continue;
+            occupied[cell >> 3] |= bit;
+        }
+        drawStamp(plotX + col, endY + row, canva_style.draw2);
+    }
+
+    // One stamp per px reached, coloured by its number of points
+    for (size_t cell = 0; counts != NULL && cell < cells; cell++)
+    {
+        if (counts[cell] == 0)
+            continue;
+        uint16_t level = (densest > 1) ? (uint32_t)(counts[cell] - 1) * (densitySize - 1) / (densest - 1) : densitySize - 1;
+        drawStamp(plotX + cell % plotW, endY + cell / plotW, densityLUT[level]);
+    }
+
+    drawLabels(labels);
+
+    scratch.release(mark);
+}
+
+template <class G, typename Y>
+void Graph_TFT::drawMinMax(const Y *y_data, uint32_t n_data, Y min_Y, Y max_Y, int32_t x, uint16_t cols, bool bars, uint16_t color)
+{
+    const G geo(graphW, graphH, canva_style);
+    int32_t last = 0;
+    uint32_t i = 0;
+    for (uint16_t col = 0; col < cols; col++, x++)
+    {
+        uint32_t end = (uint64_t)(col + 1) * n_data / cols;
+        if (end == i)
+            continue;
+
+        // Only the extremes of the column are scaled, the samples are just compared
+        Y lo = y_data[i];
+        Y hi = y_data[i];
+        int32_t first = startY - Graph_Scale<Y>::map(y_data[i], min_Y, max_Y, geo.graphH());
+        for (i++; i < end; i++)
+        {
+            lo = (y_data[i] < lo) ? y_data[i] : lo;
+            hi = (y_data[i] > hi) ? y_data[i] : hi;
+        }
+
+        int32_t top = startY - Graph_Scale<Y>::map(hi, min_Y, max_Y, geo.graphH());
+        if (bars)
+        {
+            tft->drawFastVLine(x, top, startY - top, color);
+            continue;
+        }
+
+        int32_t bottom = startY - Graph_Scale<Y>::map(lo, min_Y, max_Y, geo.graphH());
+        if (col > 0)
+        {
+            tft->drawLine(x - 1, last, x, first, color);
+        }
+        tft->drawFastVLine(x, top, bottom - top + 1, color);
+        last = startY - Graph_Scale<Y>::map(y_data[end - 1], min_Y, max_Y, geo.graphH());
+    }
+}
+
+template <class G, typename Y>
+void Graph_TFT::drawLTTB(const Y *y_data, uint32_t n_data, Y min_Y, Y max_Y, int32_t x, uint16_t cols, uint16_t color)
+{
+    const G geo(graphW, graphH, canva_style);
+    if (cols < 3 || n_data <= cols)
+    {
+        drawMinMax<G>(y_data, n_data, min_Y, max_Y, x, cols, false, color);
+        return;
+    }
+
+    // Points are compared in (index, px) units, scaling x evenly doesn't change which one is kept
+    uint32_t a = 0;
+    int32_t ay = startY - Graph_Scale<Y>::map(y_data[0], min_Y, max_Y, geo.graphH());
+    uint32_t buckets = cols - 2;
+
+    for (uint32_t b = 0; b < buckets; b++)
+    {
+        uint32_t start = 1 + (uint64_t)b * (n_data - 2) / buckets;
+        uint32_t end = 1 + (uint64_t)(b + 1) * (n_data - 2) / buckets;
+        uint32_t nextEnd = (b + 1 < buckets) ? 1 + (uint64_t)(b + 2) * (n_data - 2) / buckets : n_data;
+
+        // Average of the next bucket (the last point for the last bucket)
+        int64_t cy = 0;
+        for (uint32_t j = end; j < nextEnd; j++)
+        {
+            cy += startY - Graph_Scale<Y>::map(y_data[j], min_Y, max_Y, geo.graphH());
+        }
+        cy /= (int64_t)(nextEnd - end);
+        int64_t cx2 = (int64_t)end + nextEnd - 1; // twice the mean index
+
+        // Keep the point of the bucket making the largest triangle with the kept one and the average
+        uint32_t best = start;
+        int32_t bestY = ay;
+        int64_t bestArea = -1;
+        for (uint32_t j = start; j < end; j++)
+        {
+            int32_t jy = startY - Graph_Scale<Y>::map(y_data[j], min_Y, max_Y, geo.graphH());
+            int64_t area = (2 * (int64_t)a - cx2) * (jy - ay) - 2 * ((int64_t)a - j) * (cy - ay);
+            area = (area < 0) ? -area : area;
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = j;
+                bestY = jy;
+            }
+        }
+
+        tft->drawLine(x + (uint64_t)a * (cols - 1) / (n_data - 1), ay, x + (uint64_t)best * (cols - 1) / (n_data - 1), bestY, color);
+        a = best;
+        ay = bestY;
+    }
+
+    int32_t ly = startY - Graph_Scale<Y>::map(y_data[n_data - 1], min_Y, max_Y, geo.graphH());
+    tft->drawLine(x + (uint64_t)a * (cols - 1) / (n_data - 1), ay, x + cols - 1, ly, color);
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y)
+{
+    if (n_data < 1)
+        return;
+
+    T min = min_Y, max = max_Y;
+    setData(renderBARS<G, T, I>, NULL, y_data, n_data, &min, &max, sizeof(T));
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y)
+{
+    if (n_data < 1)
+        return;
+
+    T min = min_Y;
+    setData(renderBARS<G, T, I>, NULL, y_data, n_data, &min, NULL, sizeof(T));
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *y_data, I n_data)
+{
+    if (n_data < 1)
+        return;
+
+    setData(renderBARS<G, T, I>, NULL, y_data, n_data, NULL, NULL, sizeof(T));
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *y_data, I n_data, const Graph_Window<T> &window)
+{
+    if (n_data < 1)
+        return;
+
+    T min = window.min(), max = window.max();
+    setData(renderBARS<G, T, I>, NULL, y_data, n_data, &min, &max, sizeof(T), NULL, false);
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y)
+{
+    if (n_data < 1)
+        return;
+
+    Y min = min_Y, max = max_Y;
+    setData(renderLINES<G, X, Y, I>, x_data, y_data, n_data, &min, &max, sizeof(Y));
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y)
+{
+    if (n_data < 1)
+        return;
+
+    Y min = min_Y;
+    setData(renderLINES<G, X, Y, I>, x_data, y_data, n_data, &min, NULL, sizeof(Y));
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *y_data, I n_data)
+{
+    if (n_data < 1)
+        return;
+
+    setData(renderLINES<G, X, Y, I>, x_data, y_data, n_data, NULL, NULL, sizeof(Y));
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *y_data, I n_data, const Graph_Window<Y> &window)
+{
+    if (n_data < 1)
+        return;
+
+    Y min = window.min(), max = window.max();
+    setData(renderLINES<G, X, Y, I>, x_data, y_data, n_data, &min, &max, sizeof(Y), NULL, false);
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout)
+{
+    if (n_data < 1 || n_series < 1)
+        return;
+
+    setData(renderBARS<G, T, I>, NULL, series, n_data, NULL, NULL, sizeof(T), NULL, true, n_series, layout == STACKED);
+}
+
+template <typename T, typename I, class G>
+void Graph_TFT::setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y)
+{
+    if (n_data < 1 || n_series < 1)
+        return;
+
+    T min = min_Y, max = max_Y;
+    setData(renderBARS<G, T, I>, NULL, series, n_data, &min, &max, sizeof(T), NULL, true, n_series, layout == STACKED);
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data)
+{
+    if (n_data < 1 || n_series < 1)
+        return;
+
+    setData(renderLINES<G, X, Y, I>, x_data, series, n_data, NULL, NULL, sizeof(Y), NULL, true, n_series);
+}
+
+template <typename X, typename Y, typename I, class G>
+void Graph_TFT::setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y)
+{
+    if (n_data < 1 || n_series < 1)
+        return;
+
+    Y min = min_Y, max = max_Y;
+    setData(renderLINES<G, X, Y, I>, x_data, series, n_data, &min, &max, sizeof(Y), NULL, true, n_series);
+}
+
+template <typename X, typename Y, typename I>
+void Graph_TFT::setDataSCATTER(const X *x_data, const Y *y_data, I n_data)
+{
+    if (n_data < 1)
+        return;
+
+    setData(renderSCATTER<X, Y, I>, x_data, y_data, n_data, NULL, NULL, sizeof(Y));
+}
+
+template <typename X, typename Y, typename I>
+void Graph_TFT::setDataSCATTER(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y)
+{
+    if (n_data < 1)
+        return;
+
+    Y min = min_Y, max = max_Y;
+    setData(renderSCATTER<X, Y, I>, x_data, y_data, n_data, &min, &max, sizeof(Y));
+}
+
+template <typename T>
+void Graph_TFT::appendSpectrum(const T *values, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y)
+{
+    if (heat.getCapacity() == 0)
+        return;
+
+    heat.push<T>(values, min_Y, max_Y);
+    heatTotal++;
+    if (retained)
+    {
+        pendingSamples++;
+        return;
+    }
+
+    beginFrame();
+    if (!deferred())
+    {
+        drawColumns(1);
+    }
+    endFrame();
+}
+
+template <typename T, typename I>
+void Graph_TFT::limits(const GRAPH_DATA &data, const T *const *series, uint8_t n_series, I n_data, T &min_Y, T &max_Y)
+{
+    if (!data.scan)
+    {
+        memcpy(&min_Y, data.min_Y, sizeof(T));
+        memcpy(&max_Y, data.max_Y, sizeof(T));
+    }
+    else
+    {
+        scanLimits(data, series, n_series, n_data, min_Y, max_Y);
+    }
+
+    // Limits both given are kept as they are
+    labelStepY = 0;
+    if (autoscaleMode == NICE && !(data.scan && data.fixedMin && data.fixedMax))
+    {
+        double lo = min_Y, hi = max_Y;
+        autoscale(lo, hi, std::is_integral<T>::value);
+        min_Y = (lo > (double)std::numeric_limits<T>::lowest()) ? (T)lo : std::numeric_limits<T>::lowest();
+        max_Y = (hi < (double)std::numeric_limits<T>::max()) ? (T)hi : std::numeric_limits<T>::max();
+    }
+}
+
+template <typename T, typename I>
+void Graph_TFT::scanLimits(const GRAPH_DATA &data, const T *const *series, uint8_t n_series, I n_data, T &min_Y, T &max_Y)
+{
+    T min, max;
+    if (data.stacked)
+    {
+        // Stacked bars start at 0 and reach the highest total of the positive values
+        double top = 0;
+        min = T();
+        for (uint32_t i = 0; i < (uint32_t)n_data; i++)
+        {
+            double total = 0;
+            for (uint8_t s = 0; s < n_series; s++)
+            {
+                T v = series[s][i];
+                min = (v < min) ? v : min;
+                total += (v > T()) ? (double)v : 0;
+            }
+            top = (total > top) ? total : top;
+        }
+        max = (top < (double)std::numeric_limits<T>::max()) ? (T)top : std::numeric_limits<T>::max();
+    }
+    else
+    {
+        minmaxValue(series[0], n_data, min, max);
+        for (uint8_t s = 1; s < n_series; s++)
+        {
+            T lo, hi;
+            minmaxValue(series[s], n_data, lo, hi);
+            min = (lo < min) ? lo : min;
+            max = (hi > max) ? hi : max;
+        }
+    }
+
+    min_Y = min;
+    max_Y = max;
+
+    // Given limits are widened to the data
+    if (data.fixedMin)
+    {
+        memcpy(&min_Y, data.min_Y, sizeof(T));
+        min_Y = (min < min_Y) ? min : min_Y;
+    }
+    if (data.fixedMax)
+    {
+        memcpy(&max_Y, data.max_Y, sizeof(T));
+        max_Y = (max > max_Y) ? max : max_Y;
+    }
+}
+
+template <typename T>
+const T *const *Graph_TFT::getSeries(const GRAPH_DATA &data, const T *&single, uint8_t &n_series)
+{
+    single = (const T *)data.y_data;
+    n_series = (data.n_series > 0) ? data.n_series : 1;
+    return (data.n_series > 0) ? (const T *const *)data.y_data : &single;
+}
+
+template <class G, typename T, typename I>
+void Graph_TFT::renderBARS(Graph_TFT &graph, const GRAPH_DATA &data)
+{
+    const T *single;
+    uint8_t n_series;
+    const T *const *series = getSeries(data, single, n_series);
+    I n_data = (I)data.n_data;
+    T min_Y, max_Y;
+    graph.limits(data, series, n_series, n_data, min_Y, max_Y);
+    graph.drawBARS<G>(series, n_series, n_data, min_Y, max_Y, data.stacked);
+}
+
+template <class G, typename X, typename Y, typename I>
+void Graph_TFT::renderLINES(Graph_TFT &graph, const GRAPH_DATA &data)
+{
+    const Y *single;
+    uint8_t n_series;
+    const Y *const *series = getSeries(data, single, n_series);
+    I n_data = (I)data.n_data;
+    Y min_Y, max_Y;
+    graph.limits(data, series, n_series, n_data, min_Y, max_Y);
+    graph.drawLINES<G>((const X *)data.x_data, series, n_series, n_data, min_Y, max_Y);
+}
+
+template <typename X, typename Y, typename I>
+void Graph_TFT::renderSCATTER(Graph_TFT &graph, const GRAPH_DATA &data)
+{
+    const X *x_data = (const X *)data.x_data;
+    const Y *y_data = (const Y *)data.y_data;
+    I n_data = (I)data.n_data;
+    X min_X, max_X;
+    Y min_Y, max_Y;
+    minmaxValue(x_data, n_data, min_X, max_X);
+    graph.limits(data, &y_data, 1, n_data, min_Y, max_Y);
+    graph.drawSCATTER(x_data, y_data, n_data, min_X, max_X, min_Y, max_Y);
+}
+
+template <typename X, typename Y>
+void Graph_TFT::quickSortX(X *arrX, Y *arrY, int32_t left, int32_t right)
+{
+    while (left < right)
+    {
+        // Obtiene el índice de partición
+        int32_t pivotIndex = partition(arrX, arrY, left, right);
+
+        // Ordena la parte menor de forma recursiva y la mayor en el bucle, la pila queda en O(log n)
+        if (pivotIndex - left < right - pivotIndex)
+        {
+            quickSortX(arrX, arrY, left, pivotIndex - 1);
+            left = pivotIndex + 1;
+        }
+        else
+        {
+            quickSortX(arrX, arrY, pivotIndex + 1, right);
+            right = pivotIndex - 1;
+        }
+    }
+}
+
+template <typename X, typename Y>
+int32_t Graph_TFT::partition(X *arrX, Y *arrY, int32_t left, int32_t right)
+{
+    X pivot = arrX[right];
+    int32_t i = left - 1;
+
+    for (int32_t j = left; j < right; j++)
+    {
+        if (arrX[j] < pivot)
+        {
+            i++;
+
+            swap(&arrX[i], &arrX[j]);
+
+            if (arrY != NULL)
+            {
+                swap(&arrY[i], &arrY[j]);
+            }
+        }
+    }
+
+    swap(&arrX[i + 1], &arrX[right]);
+
+    if (arrY != NULL)
+    {
+        swap(&arrY[i + 1], &arrY[right]);
+    }
+
+    return i + 1;
+}
+
+template <typename T>
+void Graph_TFT::swap(T *a, T *b)
+{
+    T temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+template <typename T, typename I>
+void Graph_TFT::minmaxValue(const T *y_data, I n_data, T &min, T &max)
+{
+    min = max = (n_data < 1) ? 0 : y_data[0];
+    for (uint32_t i = 1; i < (uint32_t)n_data; i++)
+    {
+        min = (y_data[i] < min) ? y_data[i] : min;
+        max = (y_data[i] > max) ? y_data[i] : max;
+    }
+}
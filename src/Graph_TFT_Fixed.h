@@ -0,0 +1,155 @@
+#pragma once
+#include "Graph_TFT.h"
+
+/**
+ * @struct Graph_Fixed_Geometry
+ * @brief Size of the graph and style of a Graph_TFT_Fixed, as compile-time constants.
+ *
+ * Given to the bar and line renderers in place of Graph_Geometry: the scale of every sample
+ * (graphH), the width of the bars (graphW) and the colours are folded into the code.
+ */
+template <uint16_t W, uint16_t H, uint8_t P, GRAPH_STYLE S>
+struct Graph_Fixed_Geometry
+{
+    Graph_Fixed_Geometry(uint16_t, uint16_t, const CANVA_STYLE &) {}
+
+    static constexpr uint16_t graphW(void) { return W - 2 * P; }
+    static constexpr uint16_t graphH(void) { return H - 2 * P; }
+    static constexpr bool fill(void) { return Graph_Theme<S>::fill; }
+    static constexpr uint16_t background(void) { return Graph_Theme<S>::background; }
+    static constexpr uint16_t draw1(void) { return Graph_Theme<S>::draw1; }
+    static constexpr uint16_t draw2(void) { return Graph_Theme<S>::draw2; }
+};
+
+/**
+ * @class Graph_TFT_Fixed
+ * @brief Graph_TFT whose size, padding and style are fixed at compile time.
+ *
+ * The layout and the colours are constants of the type, so buffers can be sized from them and an
+ * impossible layout fails to compile. The bars and lines set through this type are drawn with
+ * Graph_Fixed_Geometry, the other graphs and the data set through a Graph_TFT reference as by
+ * Graph_TFT. Only the position of the canvas is given at run time. The style setters are hidden,
+ * and ignored when called through a Graph_TFT reference (a Graph_Dashboard), so the style can't
+ * change.
+ * @tparam W Width of the canvas.
+ * @tparam H Height of the canvas.
+ * @tparam P Padding around the graph.
+ * @tparam S Style of the graph.
+ * @tparam R Rounded corners of the canvas (default is DEFAULT_ROUNDED).
+ */
+template <uint16_t W, uint16_t H, uint8_t P, GRAPH_STYLE S, uint8_t R = DEFAULT_ROUNDED>
+class Graph_TFT_Fixed : public Graph_TFT
+{
+    static_assert(W > 2 * P + 4 && H > 2 * P + 2, "the padding leaves no room for the graph");
+    static_assert(2 * R <= W && 2 * R <= H, "the rounded corners are larger than the canvas");
+
+    // Every public setter of the style colours, setCanva being private already
+    using Graph_TFT::setStyle;
+    using Graph_TFT::setBackgroudColour;
+    using Graph_TFT::setDrawingPrimaryColour;
+    using Graph_TFT::setDrawingSecondaryColour;
+
+public:
+    typedef Graph_Theme<S> Theme; ///< Colours of the style.
+    typedef Graph_Fixed_Geometry<W, H, P, S> Geometry; ///< Geometry given to the bar and line renderers.
+
+    static constexpr uint16_t CANVAS_W = W;               ///< Width of the canvas.
+    static constexpr uint16_t CANVAS_H = H;               ///< Height of the canvas.
+    static constexpr uint32_t CANVAS_PIXELS = (uint32_t)W * H; ///< Pixels of a framebuffer or static layer.
+    static constexpr uint16_t GRAPH_W = W - 2 * P;        ///< Width of the graph between the paddings.
+    static constexpr uint16_t GRAPH_H = H - 2 * P;        ///< Height of the graph between the paddings.
+    static constexpr uint16_t PLOT_W = GRAPH_W - 2;       ///< Width of the data area, right of the y-axis.
+
+    /**
+     * @brief Constructor for the Graph_TFT_Fixed class.
+     * @param target Pointer to the drawing target.
+     * @param x X-coordinate of the canvas starting point from Top-Left.
+     * @param y Y-coordinate of the canvas starting point from Top-Left.
+     */
+    Graph_TFT_Fixed(Graph_Target *target, uint16_t x, uint16_t y) : Graph_TFT(target, x, y, W, H, P, R, S) { lockStyle(); }
+
+#ifdef ARDUINO
+    /**
+     * @brief Constructor for the Graph_TFT_Fixed class.
+     * @param display Pointer to the TFT display object.
+     * @param x X-coordinate of the canvas starting point from Top-Left.
+     * @param y Y-coordinate of the canvas starting point from Top-Left.
+     */
+    Graph_TFT_Fixed(TFT_eSPI *display, uint16_t x, uint16_t y) : Graph_TFT(display, x, y, W, H, P, R, S) { lockStyle(); }
+#endif
+
+    /*
+     * The setters of Graph_TFT, drawn with the constants of the type (see Graph_TFT for the parameters).
+     */
+    template <typename T, typename I>
+    void setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(y_data, n_data, min_Y, max_Y);
+    }
+
+    template <typename T, typename I>
+    void setDataBARS(const T *y_data, I n_data, typename Graph_Type<T>::type min_Y)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(y_data, n_data, min_Y);
+    }
+
+    template <typename T, typename I>
+    void setDataBARS(const T *y_data, I n_data)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(y_data, n_data);
+    }
+
+    template <typename T, typename I>
+    void setDataBARS(const T *y_data, I n_data, const Graph_Window<T> &window)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(y_data, n_data, window);
+    }
+
+    template <typename T, typename I>
+    void setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout = GROUPED)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(series, n_series, n_data, layout);
+    }
+
+    template <typename T, typename I>
+    void setDataBARS(const T *const *series, uint8_t n_series, I n_data, GRAPH_BARS layout, typename Graph_Type<T>::type min_Y, typename Graph_Type<T>::type max_Y)
+    {
+        Graph_TFT::setDataBARS<T, I, Geometry>(series, n_series, n_data, layout, min_Y, max_Y);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, y_data, n_data, min_Y, max_Y);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, typename Graph_Type<Y>::type min_Y)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, y_data, n_data, min_Y);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, y_data, n_data);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *y_data, I n_data, const Graph_Window<Y> &window)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, y_data, n_data, window);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, series, n_series, n_data);
+    }
+
+    template <typename X, typename Y, typename I>
+    void setDataLINES(const X *x_data, const Y *const *series, uint8_t n_series, I n_data, typename Graph_Type<Y>::type min_Y, typename Graph_Type<Y>::type max_Y)
+    {
+        Graph_TFT::setDataLINES<X, Y, I, Geometry>(x_data, series, n_series, n_data, min_Y, max_Y);
+    }
+};
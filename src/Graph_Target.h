@@ -0,0 +1,180 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* SPI traffic model used by the counters (ST77xx style controllers) */
+#define GRAPH_SPI_WINDOW_BYTES 11 ///< CASET(1+4) + RASET(1+4) + RAMWR(1) bytes per address window.
+#define GRAPH_SPI_PIXEL_BYTES 2   ///< Bytes per RGB565 pixel.
+#define GRAPH_EXPAND_PIXELS 64    ///< Pixels expanded from palette indices at a time when pushing an indexed block.
+
+/**
+ * @brief Expand palette indices to RGB565 pixels.
+ * @param row Indices, two per byte (high nibble first) at 4 bpp.
+ * @param first Index of the first pixel to expand in row.
+ * @param n Number of pixels.
+ * @param bpp Bits per index, 4 or 8.
+ * @param palette RGB565 colour of every index.
+ * @param out Expanded pixels.
+ */
+inline void graphExpand(const uint8_t *row, int32_t first, int32_t n, uint8_t bpp, const uint16_t *palette, uint16_t *out)
+{
+    if (bpp == 8)
+    {
+        for (int32_t i = 0; i < n; i++)
+            out[i] = palette[row[first + i]];
+        return;
+    }
+    for (int32_t i = 0, p = first; i < n; i++, p++)
+        out[i] = palette[(p & 1) ? row[p >> 1] & 0x0f : row[p >> 1] >> 4];
+}
+
+/**
+ * @struct GRAPH_COUNTERS
+ * @brief Traffic counters kept by every drawing target.
+ */
+struct GRAPH_COUNTERS
+{
+    uint32_t primitives; ///< Number of drawing calls received.
+    uint32_t pixels;     ///< Number of pixels written.
+    uint32_t bytes;      ///< Bytes that would go over SPI (address windows + pixel data).
+};
+
+/**
+ * @class Graph_Target
+ * @brief Drawing target used by Graph_TFT.
+ *
+ * Mirrors the subset of the TFT_eSPI API used by the graphs, so that the same rendering code can
+ * draw on a panel (Graph_eSPI), on a RAM buffer (Graph_Raster) or on any other backend.
+ * Coordinates are absolute screen coordinates.
+ */
+class Graph_Target
+{
+public:
+    Graph_Target(void) { resetCounters(); }
+    virtual ~Graph_Target() {}
+
+    virtual void drawPixel(int32_t x, int32_t y, uint16_t color) = 0;
+    virtual void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color) = 0;
+    virtual void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color) = 0;
+    virtual void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) = 0;
+    virtual void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) = 0;
+    virtual void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color) = 0;
+    virtual void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color) = 0;
+    virtual void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color) = 0;
+    virtual void drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color) = 0;
+    virtual void fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color) = 0;
+    virtual void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color) = 0;
+
+    /**
+     * @brief Draw a string with the built-in 6x8 font, top-left datum.
+     * @return Width of the string in px.
+     */
+    virtual int16_t drawString(const char *string, int32_t x, int32_t y) = 0;
+
+    /**
+     * @brief Draw an integer with the built-in 6x8 font, top-left datum.
+     * @return Width of the number in px.
+     */
+    virtual int16_t drawNumber(long value, int32_t x, int32_t y) = 0;
+
+    /**
+     * @brief Write a block of RGB565 pixels through a single address window.
+     * @param x Screen X-coordinate of the block.
+     * @param y Screen Y-coordinate of the block.
+     * @param w Width of the block.
+     * @param h Height of the block.
+     * @param data Pixels of the block, row-major.
+     * @param stride Distance in pixels between two rows of data (0 if equal to w).
+     */
+    virtual void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride = 0) = 0;
+
+    /**
+     * @brief Write a block of palette indices as RGB565 pixels through a single address window.
+     *
+     * The indices are expanded GRAPH_EXPAND_PIXELS at a time, so the block never exists in RGB565
+     * as a whole. The default implementation pushes every expanded run as its own block.
+     * @param x Screen X-coordinate of the block.
+     * @param y Screen Y-coordinate of the block.
+     * @param w Width of the block.
+     * @param h Height of the block.
+     * @param data Indices of the block, row-major, two per byte (high nibble first) at 4 bpp.
+     * @param first Index of the first pixel of the block in the first row of data.
+     * @param stride Distance in bytes between two rows of data.
+     * @param bpp Bits per index, 4 or 8.
+     * @param palette RGB565 colour of every index.
+     */
+    virtual void pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                             uint8_t bpp, const uint16_t *palette)
+    {
+        uint16_t pixels[GRAPH_EXPAND_PIXELS];
+        for (int32_t j = 0; j < h; j++)
+        {
+            for (int32_t i = 0; i < w; i += GRAPH_EXPAND_PIXELS)
+            {
+                int32_t n = (w - i < GRAPH_EXPAND_PIXELS) ? w - i : GRAPH_EXPAND_PIXELS;
+                graphExpand(data + j * stride, first + i, n, bpp, palette, pixels);
+                pushImage(x + i, y + j, n, 1, pixels);
+            }
+        }
+    }
+
+    /**
+     * @brief Start writing a contiguous block of RGB565 pixels, without waiting for the transfer.
+     *
+     * The data must stay untouched until busy() returns false. Targets without asynchronous
+     * transfers write the block before returning.
+     * @param x Screen X-coordinate of the block.
+     * @param y Screen Y-coordinate of the block.
+     * @param w Width of the block.
+     * @param h Height of the block.
+     * @param data Pixels of the block, row-major.
+     */
+    virtual void pushImageAsync(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) { pushImage(x, y, w, h, data); }
+
+    /**
+     * @brief Check whether an asynchronous transfer is in progress.
+     */
+    virtual bool busy(void) { return false; }
+
+    /**
+     * @brief Wait for the asynchronous transfer in progress, if any.
+     */
+    virtual void wait(void) {}
+
+    virtual void setTextSize(uint8_t size) = 0;
+    virtual void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false) = 0;
+
+    /**
+     * @brief Get the traffic counters accumulated since the last reset.
+     */
+    const GRAPH_COUNTERS &getCounters(void) const { return counters; }
+
+    /**
+     * @brief Reset the traffic counters.
+     */
+    void resetCounters(void)
+    {
+        counters.primitives = 0;
+        counters.pixels = 0;
+        counters.bytes = 0;
+    }
+
+protected:
+    GRAPH_COUNTERS counters; ///< Traffic counters.
+
+    /**
+     * @brief Account one drawing call.
+     */
+    void countPrimitive(void) { counters.primitives++; }
+
+    /**
+     * @brief Account pixels written through a number of address windows.
+     * @param pixels Number of pixels written.
+     * @param windows Number of address windows opened to write them.
+     */
+    void countPixels(uint32_t pixels, uint32_t windows)
+    {
+        counters.pixels += pixels;
+        counters.bytes += pixels * GRAPH_SPI_PIXEL_BYTES + windows * GRAPH_SPI_WINDOW_BYTES;
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+#include "Graph_Ring.h"
+
+#define GRAPH_WINDOW_MAX 32767 ///< Maximum capacity of a Graph_Window.
+
+/**
+ * @class Graph_Window
+ * @brief Sliding window over the last samples of a stream, with min, max, mean and variance in O(1).
+ *
+ * The min and max come from two monotonic deques of sample positions: each push drops from the
+ * back the samples it dominates and from the front the samples leaving the window, so every sample
+ * enters and leaves each deque once (amortized O(1) per push). The mean and variance come from
+ * running sums; the sums that can lose precision (floating point types, squares of wide integers)
+ * are recomputed from the window once every capacity pushes, which keeps the cost O(1) amortized.
+ * @tparam T Arithmetic type of the samples.
+ */
+template <typename T>
+class Graph_Window
+{
+private:
+    /* Exact sum for integers, double for floating point types */
+    typedef typename std::conditional<std::is_integral<T>::value, int64_t, double>::type Sum;
+
+    Graph_Ring<T> values; ///< Samples of the window.
+    uint16_t *minQ;       ///< Deque of the positions of the increasing minima.
+    uint16_t *maxQ;       ///< Deque of the positions of the decreasing maxima.
+    uint16_t capacity;    ///< Size of the window.
+    uint16_t minHead, minCount; ///< Front and size of minQ.
+    uint16_t maxHead, maxCount; ///< Front and size of maxQ.
+    uint16_t next;        ///< Position of the next sample, modulo 2^16.
+    Sum sum;              ///< Sum of the samples.
+    double squares;       ///< Sum of the squares of the samples.
+    uint16_t drift;       ///< Pushes since the sums were recomputed.
+
+    /* Sample at a position still in the window */
+    T at(uint16_t position) const { return values[values.size() - (uint16_t)(next - position)]; }
+
+    bool inWindow(uint16_t position) const { return (uint16_t)(next - position) <= values.size(); }
+
+    uint16_t slot(uint16_t head, uint16_t i) const
+    {
+        uint32_t s = (uint32_t)head + i;
+        return (s >= capacity) ? s - capacity : s;
+    }
+
+    /**
+     * @brief Drop the positions that left the window from the front of a deque, then the ones
+     * dominated by the new sample from its back, and append the new sample.
+     */
+    void enqueue(uint16_t *queue, uint16_t &head, uint16_t &count, T value, bool max)
+    {
+        while (count > 0 && !inWindow(queue[head]))
+        {
+            head = slot(head, 1);
+            count--;
+        }
+        while (count > 0)
+        {
+            T back = at(queue[slot(head, count - 1)]);
+            if (max ? (back > value) : (back < value))
+                break;
+            count--;
+        }
+        queue[slot(head, count)] = (uint16_t)(next - 1);
+        count++;
+    }
+
+    void resum(void)
+    {
+        sum = 0;
+        squares = 0;
+        for (uint16_t i = 0; i < values.size(); i++)
+        {
+            sum += values[i];
+            squares += (double)values[i] * values[i];
+        }
+        drift = 0;
+    }
+
+public:
+    /**
+     * @brief Constructor for the Graph_Window class.
+     * @param buffer Storage for capacity samples (NULL for an empty window).
+     * @param deques Storage for 2 * capacity positions.
+     * @param capacity Number of samples of the window, up to GRAPH_WINDOW_MAX.
+     */
+    Graph_Window(T *buffer = NULL, uint16_t *deques = NULL, uint16_t capacity = 0)
+        : values(buffer, (buffer && deques) ? ((capacity < GRAPH_WINDOW_MAX) ? capacity : GRAPH_WINDOW_MAX) : 0),
+          minQ(deques), maxQ(deques + values.getCapacity()), capacity(values.getCapacity())
+    {
+        clear();
+    }
+
+    /**
+     * @brief Append a sample, dropping the oldest one if the window is full.
+     * @param value Sample to append.
+     */
+    void push(T value)
+    {
+        if (capacity == 0)
+            return;
+
+        if (values.size() == capacity)
+        {
+            T old = values[0];
+            sum -= old;
+            squares -= (double)old * old;
+        }
+        values.push(value);
+        sum += value;
+        squares += (double)value * value;
+        next++;
+
+        enqueue(minQ, minHead, minCount, value, false);
+        enqueue(maxQ, maxHead, maxCount, value, true);
+
+        if ((!std::is_integral<T>::value || sizeof(T) > 2) && ++drift >= capacity)
+        {
+            resum();
+        }
+    }
+
+    /**
+     * @brief Remove every sample.
+     */
+    void clear(void)
+    {
+        values.clear();
+        minHead = minCount = 0;
+        maxHead = maxCount = 0;
+        next = 0;
+        sum = 0;
+        squares = 0;
+        drift = 0;
+    }
+
+    /**
+     * @brief Get the lowest sample of the window, 0 if empty.
+     */
+    T min(void) const { return (minCount > 0) ? at(minQ[minHead]) : T(); }
+
+    /**
+     * @brief Get the highest sample of the window, 0 if empty.
+     */
+    T max(void) const { return (maxCount > 0) ? at(maxQ[maxHead]) : T(); }
+
+    /**
+     * @brief Get the mean of the window, 0 if empty.
+     */
+    double mean(void) const { return (values.size() > 0) ? (double)sum / values.size() : 0; }
+
+    /**
+     * @brief Get the population variance of the window, 0 if empty.
+     */
+    double variance(void) const
+    {
+        if (values.size() == 0)
+            return 0;
+        double m = mean();
+        double v = squares / values.size() - m * m;
+        return (v > 0) ? v : 0;
+    }
+
+    /**
+     * @brief Get a sample.
+     * @param i Index of the sample, 0 being the oldest one.
+     */
+    T operator[](uint16_t i) const { return values[i]; }
+
+    uint16_t size(void) const { return values.size(); }
+    uint16_t getCapacity(void) const { return capacity; }
+};
@@ -0,0 +1,244 @@
+#pragma once
+#include <string.h>
+#include <TFT_eSPI.h>
+#include "Graph_Target.h"
+
+/**
+ * @class Graph_eSPI
+ * @brief Drawing target forwarding to a TFT_eSPI panel.
+ *
+ * The counters are estimated from the primitive geometry, following the way TFT_eSPI splits each
+ * primitive into address windows. pushImageAsync uses the TFT_eSPI DMA engine once initDMA() was
+ * called on the display; any other call waits for the transfer in progress first.
+ *
+ * TFT_eSPI swaps the bytes of a DMA image in place when setSwapBytes(true) is set. The images
+ * are then copied to a DMA bounce buffer first (setDMABuffer), or pushed synchronously without
+ * one, so the caller's pixels are never written.
+ */
+class Graph_eSPI : public Graph_Target
+{
+private:
+    TFT_eSPI *tft;        ///< Pointer to the TFT display object.
+    bool pending = false; ///< Whether a DMA transfer was started and not waited for yet.
+    uint16_t *bounce = NULL; ///< DMA buffer the images are copied to (and swapped in), NULL if none.
+    uint32_t bouncePixels = 0; ///< Size of the bounce buffer in pixels.
+
+    static int32_t absInt(int32_t v) { return (v < 0) ? -v : v; }
+
+public:
+    /**
+     * @brief Constructor for the Graph_eSPI class.
+     * @param display Pointer to the TFT display object.
+     */
+    Graph_eSPI(TFT_eSPI *display = NULL) : tft(display) {}
+
+    TFT_eSPI *getDisplay(void) { return tft; }
+
+    /**
+     * @brief Set the buffer the DMA images are copied to before the transfer.
+     * @param buffer DMA capable buffer, or NULL to push swapped images synchronously.
+     * @param pixels Size of the buffer in pixels, larger images are pushed synchronously.
+     */
+    void setDMABuffer(uint16_t *buffer, uint32_t pixels)
+    {
+        wait();
+        bounce = buffer;
+        bouncePixels = buffer ? pixels : 0;
+    }
+
+    void drawPixel(int32_t x, int32_t y, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(1, 1);
+        tft->drawPixel(x, y, color);
+    }
+
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(w, 1);
+        tft->drawFastHLine(x, y, w, color);
+    }
+
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(h, 1);
+        tft->drawFastVLine(x, y, h, color);
+    }
+
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(w * h, 1);
+        tft->fillRect(x, y, w, h, color);
+    }
+
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(2 * (w + h), 4);
+        tft->drawRect(x, y, w, h, color);
+    }
+
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+    {
+        int32_t dx = absInt(x1 - x0);
+        int32_t dy = absInt(y1 - y0);
+        wait();
+        countPrimitive();
+        countPixels(((dx > dy) ? dx : dy) + 1, ((dx < dy) ? dx : dy) + 1);
+        tft->drawLine(x0, y0, x1, y1, color);
+    }
+
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(2 * (w + h), 4 + 4 * r);
+        tft->drawRoundRect(x, y, w, h, r, color);
+    }
+
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(w * h, 1 + 2 * r);
+        tft->fillRoundRect(x, y, w, h, r, color);
+    }
+
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(2 * 314 * r / 100, 2 * 314 * r / 100);
+        tft->drawCircle(x, y, r, color);
+    }
+
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+    {
+        wait();
+        countPrimitive();
+        countPixels(314 * r * r / 100 + 2 * r + 1, 4 * r + 1);
+        tft->fillCircle(x, y, r, color);
+    }
+
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+    {
+        int32_t area = absInt((x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0)) / 2;
+        int32_t top = (y0 < y1) ? ((y0 < y2) ? y0 : y2) : ((y1 < y2) ? y1 : y2);
+        int32_t bottom = (y0 > y1) ? ((y0 > y2) ? y0 : y2) : ((y1 > y2) ? y1 : y2);
+        wait();
+        countPrimitive();
+        countPixels(area + bottom - top + 1, bottom - top + 1);
+        tft->fillTriangle(x0, y0, x1, y1, x2, y2, color);
+    }
+
+    int16_t drawString(const char *string, int32_t x, int32_t y)
+    {
+        uint32_t n = (string != NULL) ? strlen(string) : 0;
+        wait();
+        countPrimitive();
+        countPixels(n * 6 * 8, n);
+        return tft->drawString(string, x, y);
+    }
+
+    int16_t drawNumber(long value, int32_t x, int32_t y)
+    {
+        uint32_t n = (value <= 0) ? 1 : 0;
+        for (long v = value; v != 0; v /= 10)
+            n++;
+        wait();
+        countPrimitive();
+        countPixels(n * 6 * 8, n);
+        return tft->drawNumber(value, x, y);
+    }
+
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride = 0)
+    {
+        wait();
+        countPrimitive();
+        countPixels(w * h, 1);
+        if (stride == 0 || stride == w)
+        {
+            tft->pushImage(x, y, w, h, (uint16_t *)data);
+            return;
+        }
+        tft->startWrite();
+        tft->setAddrWindow(x, y, w, h);
+        for (int32_t j = 0; j < h; j++)
+        {
+            tft->pushPixels(data + j * stride, w);
+        }
+        tft->endWrite();
+    }
+
+    void pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                     uint8_t bpp, const uint16_t *palette)
+    {
+        // One address window, the indices expanded a run at a time while the pixels stream out
+        uint16_t pixels[GRAPH_EXPAND_PIXELS];
+        wait();
+        countPrimitive();
+        countPixels(w * h, 1);
+        tft->startWrite();
+        tft->setAddrWindow(x, y, w, h);
+        for (int32_t j = 0; j < h; j++)
+        {
+            for (int32_t i = 0; i < w; i += GRAPH_EXPAND_PIXELS)
+            {
+                int32_t n = (w - i < GRAPH_EXPAND_PIXELS) ? w - i : GRAPH_EXPAND_PIXELS;
+                graphExpand(data + j * stride, first + i, n, bpp, palette, pixels);
+                tft->pushPixels(pixels, n);
+            }
+        }
+        tft->endWrite();
+    }
+
+    void pushImageAsync(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+    {
+        bool copied = bounce != NULL && (uint32_t)(w * h) <= bouncePixels;
+        if (!tft->DMA_Enabled || (tft->getSwapBytes() && !copied))
+        {
+            pushImage(x, y, w, h, data);
+            return;
+        }
+
+        wait();
+        countPrimitive();
+        countPixels(w * h, 1);
+        tft->startWrite();
+        // The image is only read: swapping happens in the bounce buffer, or not at all
+        tft->pushImageDMA(x, y, w, h, const_cast<uint16_t *>(data), copied ? bounce : NULL);
+        pending = true;
+    }
+
+    bool busy(void)
+    {
+        return pending && tft->dmaBusy();
+    }
+
+    void wait(void)
+    {
+        if (!pending)
+            return;
+        tft->dmaWait();
+        tft->endWrite();
+        pending = false;
+    }
+
+    void setTextSize(uint8_t size)
+    {
+        tft->setTextSize(size);
+    }
+
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false)
+    {
+        tft->setTextColor(fg, bg, bgfill);
+    }
+};
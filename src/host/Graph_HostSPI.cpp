@@ -0,0 +1,235 @@
+#include "Graph_HostSPI.h"
+#include <chrono>
+
+Graph_HostSPI::Graph_HostSPI(Graph_Target *target, uint32_t bandwidth)
+    : target(target), bandwidth(bandwidth ? bandwidth : 1), pending(false), copying(false), quit(false), transmitUs(0)
+{
+    worker = std::thread(&Graph_HostSPI::run, this);
+}
+
+Graph_HostSPI::~Graph_HostSPI()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    signal.notify_all();
+    worker.join();
+}
+
+std::chrono::nanoseconds Graph_HostSPI::delay(uint32_t bytes) const
+{
+    return std::chrono::nanoseconds((uint64_t)bytes * 1000000000ULL / bandwidth);
+}
+
+void Graph_HostSPI::transmit(uint32_t bytes)
+{
+    // Spin rather than sleep, the transfers are far shorter than the scheduler granularity
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + delay(bytes);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+    transmitUs += std::chrono::duration_cast<std::chrono::microseconds>(delay(bytes)).count();
+}
+
+void Graph_HostSPI::account(const GRAPH_COUNTERS &before)
+{
+    const GRAPH_COUNTERS &after = target->getCounters();
+    counters.primitives += after.primitives - before.primitives;
+    counters.pixels += after.pixels - before.pixels;
+    counters.bytes += after.bytes - before.bytes;
+    transmit(after.bytes - before.bytes);
+}
+
+void Graph_HostSPI::run(void)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        signal.wait(guard, [this] { return copying || quit; });
+        if (quit)
+            return;
+
+        // The pixels land at once, the transfer completes when its bytes went over the link
+        guard.unlock();
+        target->pushImage(jobX, jobY, jobW, jobH, jobData);
+        guard.lock();
+
+        copying = false;
+        signal.notify_all();
+    }
+}
+
+void Graph_HostSPI::pushImageAsync(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+    wait();
+    countPrimitive();
+    countPixels(w * h, 1);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobX = x;
+        jobY = y;
+        jobW = w;
+        jobH = h;
+        jobData = data;
+        jobBytes = w * h * GRAPH_SPI_PIXEL_BYTES + GRAPH_SPI_WINDOW_BYTES;
+        due = std::chrono::steady_clock::now() + delay(jobBytes);
+        pending = true;
+        copying = true;
+    }
+    signal.notify_all();
+}
+
+bool Graph_HostSPI::busy(void)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return pending && (copying || std::chrono::steady_clock::now() < due);
+}
+
+void Graph_HostSPI::wait(void)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    if (!pending)
+        return;
+    signal.wait(guard, [this] { return !copying; });
+    while (std::chrono::steady_clock::now() < due)
+    {
+    }
+    transmitUs += std::chrono::duration_cast<std::chrono::microseconds>(delay(jobBytes)).count();
+    pending = false;
+}
+
+void Graph_HostSPI::drawPixel(int32_t x, int32_t y, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawPixel(x, y, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawFastHLine(x, y, w, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawFastVLine(x, y, h, color);
+    account(before);
+}
+
+void Graph_HostSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->fillRect(x, y, w, h, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawRect(x, y, w, h, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawLine(x0, y0, x1, y1, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawRoundRect(x, y, w, h, r, color);
+    account(before);
+}
+
+void Graph_HostSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->fillRoundRect(x, y, w, h, r, color);
+    account(before);
+}
+
+void Graph_HostSPI::drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->drawCircle(x, y, r, color);
+    account(before);
+}
+
+void Graph_HostSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->fillCircle(x, y, r, color);
+    account(before);
+}
+
+void Graph_HostSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->fillTriangle(x0, y0, x1, y1, x2, y2, color);
+    account(before);
+}
+
+int16_t Graph_HostSPI::drawString(const char *string, int32_t x, int32_t y)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    int16_t w = target->drawString(string, x, y);
+    account(before);
+    return w;
+}
+
+int16_t Graph_HostSPI::drawNumber(long value, int32_t x, int32_t y)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    int16_t w = target->drawNumber(value, x, y);
+    account(before);
+    return w;
+}
+
+void Graph_HostSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->pushImage(x, y, w, h, data, stride);
+    account(before);
+}
+
+void Graph_HostSPI::pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                                uint8_t bpp, const uint16_t *palette)
+{
+    wait();
+    GRAPH_COUNTERS before = target->getCounters();
+    target->pushIndexed(x, y, w, h, data, first, stride, bpp, palette);
+    account(before);
+}
+
+void Graph_HostSPI::setTextSize(uint8_t size)
+{
+    wait();
+    target->setTextSize(size);
+}
+
+void Graph_HostSPI::setTextColor(uint16_t fg, uint16_t bg, bool bgfill)
+{
+    wait();
+    target->setTextColor(fg, bg, bgfill);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "../Graph_Target.h"
+
+/**
+ * @class Graph_HostSPI
+ * @brief Host stand-in for a SPI panel with a DMA engine.
+ *
+ * Forwards every call to another target (usually a Graph_Raster holding the screen) and holds the
+ * caller for the time the bytes would take on a link of the given bandwidth. pushImageAsync hands
+ * the block to a transmit thread and returns at once, like a DMA transfer, so the overlap of
+ * rendering and transmission can be measured. The transfer takes no CPU time: it completes at a
+ * deadline, which wait spins on like a driver polling the DMA engine.
+ */
+class Graph_HostSPI : public Graph_Target
+{
+private:
+    Graph_Target *target;  ///< Target receiving the pixels.
+    uint32_t bandwidth;    ///< Link bandwidth in bytes per second.
+    std::thread worker;    ///< Transmit thread.
+    std::mutex lock;       ///< Protects the job and the flags.
+    std::condition_variable signal; ///< Wakes the transmit thread and the waiters.
+    bool pending;          ///< Whether a transfer was started and not waited for.
+    bool copying;          ///< Whether the transmit thread still has to copy the pixels of the transfer.
+    bool quit;             ///< Whether the transmit thread must stop.
+    int32_t jobX, jobY, jobW, jobH; ///< Block of the transfer.
+    const uint16_t *jobData;        ///< Pixels of the transfer.
+    uint32_t jobBytes;              ///< Bytes of the transfer.
+    std::chrono::steady_clock::time_point due; ///< Time the transfer completes.
+    uint64_t transmitUs;   ///< Total time spent transmitting.
+
+    /**
+     * @brief Time a number of bytes takes on the link.
+     */
+    std::chrono::nanoseconds delay(uint32_t bytes) const;
+
+    /**
+     * @brief Hold the caller for the time the bytes take on the link.
+     */
+    void transmit(uint32_t bytes);
+
+    /**
+     * @brief Account the traffic of a forwarded call and hold the caller for its transmission.
+     * @param before Counters of the target before the call.
+     */
+    void account(const GRAPH_COUNTERS &before);
+
+    void run(void);
+
+public:
+    /**
+     * @brief Constructor for the Graph_HostSPI class.
+     * @param target Target receiving the pixels.
+     * @param bandwidth Link bandwidth in bytes per second.
+     */
+    Graph_HostSPI(Graph_Target *target, uint32_t bandwidth);
+    ~Graph_HostSPI();
+
+    void drawPixel(int32_t x, int32_t y, uint16_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint16_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint16_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color);
+    int16_t drawString(const char *string, int32_t x, int32_t y);
+    int16_t drawNumber(long value, int32_t x, int32_t y);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride = 0);
+    void pushIndexed(int32_t x, int32_t y, int32_t w, int32_t h, const uint8_t *data, int32_t first, int32_t stride,
+                     uint8_t bpp, const uint16_t *palette);
+    void pushImageAsync(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    bool busy(void);
+    void wait(void);
+    void setTextSize(uint8_t size);
+    void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false);
+
+    /**
+     * @brief Get the total time spent transmitting, synchronously or not, in microseconds.
+     */
+    uint64_t getTransmitUs(void) const { return transmitUs; }
+};
@@ -0,0 +1,1002 @@
+/*
+ * Host renderer for Graph_TFT.
+ *
+ * Renders every graph type into an in-memory RGB565 screen, dumps the frames as PPM images and
+ * reports the traffic each render would send to the panel, and the heap allocations made while
+ * rendering (there must be none).
+ *
+ * The link and async modes send the frames over Graph_HostSPI, a stand-in for a SPI panel of the
+ * given bandwidth (bytes/s): link pushes them synchronously, async with double-buffered DMA.
+ * The indexed modes compose the frames in 8 and 4 bits per pixel palette indices. The listed mode
+ * records the frames as display lists and only sends the areas that changed; the list run checks
+ * that a change of drawing order is one of them. The strips mode
+ * rasterizes the frames 16 rows at a time through a small buffer.
+ *
+ * The dashboard run shares the screen between four charts fed at different rates, drawn under a
+ * per-frame byte budget.
+ *
+ * The queue run stress-tests Graph_Queue between a producer thread and a consumer, then feeds a
+ * streaming chart from a producer thread while the main thread renders.
+ *
+ * The burst run applies several changes per loop iteration, drawn at once (immediate mode) or
+ * collapsed into capped frames (retained mode).
+ *
+ * The fixed run times the same bar and line charts with Graph_TFT and with Graph_TFT_Fixed, whose
+ * renderers scale with compile-time constants, and checks that they draw the same pixels.
+ *
+ * The ingest run records a capture of framed binary samples (Graph_Ingest) with corrupted, missing
+ * and garbage frames, then feeds it through a pipe in uneven chunks into a three series chart and
+ * checks the counters. Given a capture source (FIFO or pseudo-terminal), it decodes that instead.
+ *
+ * The exit status is 1 if a check failed: a heap allocation while rendering, different pixels,
+ * a stale overlap, a queue item out of order or unexpected ingest counters.
+ *
+ * Usage: graph_host [output_dir] [frames] [bandwidth] [capture_source]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <math.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <new>
+#include <thread>
+#include "../Graph_TFT.h"
+#include "../Graph_Raster.h"
+#include "Graph_HostSPI.h"
+#include "../Graph_Dashboard.h"
+#include "../Graph_TFT_Fixed.h"
+#include "../Graph_Ingest.h"
+
+#define SCREEN_WIDTH 128
+#define SCREEN_HEIGHT 128
+#define CANVA_X 4
+#define CANVA_Y 4
+#define CANVA_W 124
+#define CANVA_H 100
+#define N 5
+#define BANDWIDTH 500000000 // The host renders ~100x faster than an ESP32, so is the link (40 MHz SPI is 5 MB/s)
+
+static uint32_t allocations = 0; ///< Heap allocations made through new since the start.
+static bool failed = false;      ///< Whether a check failed, the runner then exits with 1.
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+typedef void (*render_fn)(Graph_TFT &canva, uint32_t frame);
+
+static uint16_t screen[SCREEN_WIDTH * SCREEN_HEIGHT];
+static uint16_t framebuffer[CANVA_W * CANVA_H];
+static uint16_t framebuffer2[CANVA_W * CANVA_H];
+static uint16_t layer[CANVA_W * CANVA_H];
+static uint8_t indexed[GRAPH_INDEXED_BYTES(CANVA_W, CANVA_H, 8)];
+static uint16_t indexedPalette[256];
+#define LIST_CAPACITY 2048
+static GRAPH_COMMAND commands[2 * LIST_CAPACITY];
+#define STRIP_ROWS 16
+static uint16_t stripBuffer[CANVA_W * STRIP_ROWS];
+
+/* Render modes of the bench */
+#define MODE_DIRECT 0   // Straight to the screen
+#define MODE_BUFFERED 1 // Composed in a framebuffer
+#define MODE_LAYERED 2  // Composed in a framebuffer over a cached static layer
+#define MODE_LINK 3     // Composed in a framebuffer, pushed over the link
+#define MODE_ASYNC 4    // Composed in two framebuffers, pushed over the link while the next one renders
+#define MODE_INDEXED8 5 // Composed in a 8 bpp palette indexed framebuffer
+#define MODE_INDEXED4 6 // Composed in a 4 bpp palette indexed framebuffer
+#define MODE_LISTED 7   // Recorded as display lists, the changed areas rasterized in the scratch memory
+#define MODE_STRIPS 8   // Rasterized in strips of STRIP_ROWS rows
+#define MODES 9
+
+static const char *modes[MODES] = {"direct", "buffered", "layered", "link", "async", "indexed8", "indexed4", "listed", "strips"};
+static uint32_t bandwidth = BANDWIDTH;
+
+static uint16_t x[N], y[N], shuffled[N];
+static uint8_t scratch[GRAPH_SCRATCH_SERIES(N, uint16_t, uint16_t) + GRAPH_SCRATCH_HEATMAP(CANVA_H) + GRAPH_SCRATCH_DENSITY(CANVA_W, CANVA_H)];
+static uint8_t percentage[N] = {10, 15, 25, 35, 15};
+static char title[] = "Host";
+
+static void renderBars(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataBARS(y, N);
+}
+
+static void renderBarsWalk(Graph_TFT &canva, uint32_t frame)
+{
+    // One bar moves by one unit per frame, on a fixed range
+    uint16_t walk[N];
+    for (int i = 0; i < N; i++)
+        walk[i] = y[i];
+    walk[frame % N] = (y[frame % N] + (frame / N) % 2) % 9;
+    canva.setDataBARS(walk, N, 0, 8);
+}
+
+static void renderBarsDrift(Graph_TFT &canva, uint32_t frame, GRAPH_AUTOSCALE mode)
+{
+    // Autoscaled bars drifting around 50, one bar changes per frame
+    static uint16_t drift[N];
+    if (frame == 0)
+    {
+        canva.setAutoscale(mode);
+        for (int i = 0; i < N; i++)
+            drift[i] = 40 + y[i] * 2;
+    }
+    uint32_t r = frame * 2654435761u;
+    drift[frame % N] = 36 + (r >> 27) + (frame / 64) % 4 * 3;
+    canva.setDataBARS(drift, N);
+}
+
+static void renderBarsExact(Graph_TFT &canva, uint32_t frame)
+{
+    renderBarsDrift(canva, frame, EXACT);
+}
+
+static void renderBarsNice(Graph_TFT &canva, uint32_t frame)
+{
+    renderBarsDrift(canva, frame, NICE);
+}
+
+static void renderStream(Graph_TFT &canva, uint32_t frame)
+{
+    static uint16_t history[256];
+    if (frame == 0)
+    {
+        canva.setStream(history, 256, 0, 8);
+    }
+    canva.appendSample(4 + ((frame * 7) % 9) / 2 - (frame / 16) % 3);
+}
+
+static void renderStreamAuto(Graph_TFT &canva, uint32_t frame)
+{
+    // Autoscaled over the last 92 samples, the plot width
+    static uint16_t history[256];
+    static uint16_t samples[92];
+    static uint16_t deques[2 * 92];
+    static Graph_Window<uint16_t> window(samples, deques, 92);
+    if (frame == 0)
+    {
+        canva.setStream(history, 256, &window);
+    }
+    canva.appendSample(400 + ((frame * 7) % 9) * 10 - (frame / 16) % 5 * 30);
+}
+
+static void renderStreamNice(Graph_TFT &canva, uint32_t frame)
+{
+    if (frame == 0)
+    {
+        canva.setAutoscale(NICE);
+    }
+    renderStreamAuto(canva, frame);
+}
+
+static void renderLines(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataLINES(x, y, N);
+}
+
+static void renderLinesUnsorted(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataLINES(shuffled, y, N);
+}
+
+static uint16_t y2[N], y3[N];
+static const uint16_t *series[3] = {y, y2, y3};
+
+static void renderMultiLines(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataLINES(x, series, 3, N);
+}
+
+static void renderMultiLinesUnsorted(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataLINES(shuffled, series, 3, N);
+}
+
+static void renderMultiGrouped(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataBARS(series, 3, N);
+}
+
+static void renderMultiStacked(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataBARS(series, 3, N, STACKED);
+}
+
+/* Spectra of 48 bins with a peak sweeping up and down, for the heatmap and its bars equivalent */
+#define BINS 48
+
+static void makeSpectrum(uint16_t *bins, uint32_t frame)
+{
+    uint32_t peak = (frame / 2) % (2 * BINS - 2);
+    peak = (peak < BINS) ? peak : 2 * BINS - 2 - peak;
+    for (uint32_t b = 0; b < BINS; b++)
+    {
+        uint32_t d = (b > peak) ? b - peak : peak - b;
+        bins[b] = ((frame * 31 + b * 17) % 13) + ((d < 8) ? (8 - d) * 12 : 0);
+    }
+}
+
+static void renderSpectrumBars(Graph_TFT &canva, uint32_t frame)
+{
+    static uint16_t bins[BINS];
+    makeSpectrum(bins, frame);
+    canva.setDataBARS(bins, BINS, 0, 108);
+}
+
+static void renderHeatmap(Graph_TFT &canva, uint32_t frame)
+{
+    static uint8_t history[128 * BINS];
+    static uint16_t lut[64];
+    uint16_t bins[BINS];
+    if (frame == 0)
+    {
+        graphHeatLUT(lut, 64);
+        canva.setHeatmap(history, 128, BINS, lut, 64);
+    }
+    makeSpectrum(bins, frame);
+    canva.appendSpectrum(bins, 0, 108);
+}
+
+/* Cloud of 10k points in two clusters, for the scatter graphs */
+#define POINTS 10000
+static uint16_t cloudX[POINTS], cloudY[POINTS];
+
+static void makeCloud(void)
+{
+    uint32_t r = 12345;
+    for (uint32_t i = 0; i < POINTS; i++)
+    {
+        // Sum of 4 uniforms, roughly normal
+        uint32_t sx = 0, sy = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            r = r * 1664525u + 1013904223u;
+            sx += r >> 24;
+            r = r * 1664525u + 1013904223u;
+            sy += r >> 24;
+        }
+        cloudX[i] = sx + ((i % 3 == 0) ? 600 : 0);
+        cloudY[i] = sy + ((i % 3 == 0) ? 300 : 0);
+    }
+}
+
+static void renderScatterRaw(Graph_TFT &canva, uint32_t frame)
+{
+    // Without scratch memory every point is stamped
+    if (frame == 0)
+    {
+        canva.setScratch(NULL, 0);
+        canva.setMarker(DISC);
+    }
+    canva.setDataSCATTER(cloudX, cloudY, POINTS);
+}
+
+static void renderScatter(Graph_TFT &canva, uint32_t frame)
+{
+    if (frame == 0)
+    {
+        canva.setMarker(DISC);
+    }
+    canva.setDataSCATTER(cloudX, cloudY, POINTS);
+}
+
+static void renderScatterDensity(Graph_TFT &canva, uint32_t frame)
+{
+    static uint16_t lut[32];
+    if (frame == 0)
+    {
+        graphHeatLUT(lut, 32);
+        canva.setDensity(lut, 32);
+    }
+    canva.setDataSCATTER(cloudX, cloudY, POINTS);
+}
+
+static void renderPie(Graph_TFT &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataPIE(percentage, N);
+}
+
+/**
+ * Render `frames` frames on a fresh screen, report the cost per frame and dump the last one.
+ */
+static void bench(const char *name, int mode, render_fn render, uint32_t frames, const char *dir)
+{
+    Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+    raster.clear(COLOR_BLACK);
+    Graph_HostSPI link(&raster, bandwidth);
+    bool linked = (mode == MODE_LINK || mode == MODE_ASYNC);
+    Graph_Target *panel = linked ? (Graph_Target *)&link : (Graph_Target *)&raster;
+
+    Graph_TFT canva(panel, CANVA_X, CANVA_Y, CANVA_W, CANVA_H, 15, 5, OCEAN);
+    if (mode == MODE_ASYNC)
+    {
+        canva.setAsyncFramebuffers(framebuffer, framebuffer2);
+    }
+    else if (mode == MODE_INDEXED8 || mode == MODE_INDEXED4)
+    {
+        canva.setIndexedFramebuffer(indexed, (mode == MODE_INDEXED8) ? 8 : 4, indexedPalette);
+    }
+    else if (mode == MODE_LISTED)
+    {
+        canva.setDisplayList(commands, LIST_CAPACITY);
+    }
+    else if (mode == MODE_STRIPS)
+    {
+        canva.setStripBuffer(stripBuffer, STRIP_ROWS);
+    }
+    else if (mode != MODE_DIRECT)
+    {
+        canva.setFramebuffer(framebuffer);
+    }
+    if (mode == MODE_LAYERED)
+    {
+        canva.setStaticLayer(layer);
+    }
+    canva.setScratch(scratch, sizeof(scratch));
+    canva.setTitle(title);
+    canva.setAxisDiv(1, 1);
+
+    panel->resetCounters();
+    uint32_t allocated = allocations;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        render(canva, f);
+    }
+    canva.waitPresent();
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    allocated = allocations - allocated;
+    failed |= allocated > 0;
+
+    const GRAPH_COUNTERS &c = panel->getCounters();
+    printf("%-8s %-8s %8.2f us/frame %6u prims %8u px %9u bytes %4u allocs %4u scratch\n", name,
+           modes[mode], elapsed / frames, c.primitives / frames, c.pixels / frames,
+           c.bytes / frames, allocated, (unsigned)canva.getScratchPeak());
+    if (linked)
+    {
+        printf("    link busy %.2f us/frame\n", (double)link.getTransmitUs() / frames);
+    }
+
+#if GRAPH_ENABLE_STATS
+    // Cost of each phase of the last frame
+    static const char *phases[GRAPH_PHASES] = {"background", "axis", "title", "data", "labels", "push"};
+    const GRAPH_STATS &s = canva.getStats();
+    for (uint8_t i = 0; i < GRAPH_PHASES; i++)
+    {
+        const GRAPH_PHASE_STATS &p = s.phase[i];
+        if (p.primitives > 0 || p.us > 0)
+        {
+            printf("    %-10s %6u us %6u prims %8u px %9u bytes\n", phases[i], p.us, p.primitives, p.pixels, p.bytes);
+        }
+    }
+    printf("    frame us min/avg/max %u/%u/%u, bytes min/avg/max %u/%u/%u\n", s.min.us, s.avg.us, s.max.us,
+           s.min.bytes, s.avg.bytes, s.max.bytes);
+#endif
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s_%s.ppm", dir, name, modes[mode]);
+    if (!raster.writePPM(path))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+    }
+}
+
+/* Dashboard: four quarter-screen charts */
+#define TILE 64
+#define DASH_BUDGET 12000 // Bytes per frame, a bit more than one chart
+#define DASH_TICK 1000    // Time between frames in microseconds
+
+static uint16_t dashBars[N];
+static uint16_t dashSlow[N];
+
+static void drawDashBars(Graph_TFT &chart, void *context)
+{
+    (void)context;
+    chart.setDataBARS(dashBars, N, 0, 8);
+}
+
+static void drawDashLines(Graph_TFT &chart, void *context)
+{
+    (void)context;
+    chart.setDataLINES(x, dashBars, N, 0, 8);
+}
+
+static void drawDashPie(Graph_TFT &chart, void *context)
+{
+    (void)context;
+    chart.setDataPIE(percentage, N);
+}
+
+/**
+ * Feed four charts at different rates for `frames` frames and report how the dashboard scheduled them.
+ */
+static void benchDashboard(uint32_t frames, const char *dir)
+{
+    static const char *names[4] = {"bars", "lines", "pie", "slow"};
+    Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+    raster.clear(COLOR_BLACK);
+
+    Graph_TFT bars(&raster, 0, 0, TILE, TILE, 8, 3, OCEAN);
+    Graph_TFT lines(&raster, TILE, 0, TILE, TILE, 8, 3, OCEAN);
+    Graph_TFT pie(&raster, 0, TILE, TILE, TILE, 8, 3, OCEAN);
+    Graph_TFT slow(&raster, TILE, TILE, TILE, TILE, 8, 3, OCEAN);
+
+    // Bars and lines share a source updated every frame, the last chart has a source updated every
+    // frame too but only needs 20 redraws per second, the pie never changes. The last chart is in
+    // retained mode: it is fed directly and marks itself changed
+    Graph_Dashboard dashboard(0, DASH_BUDGET);
+    int8_t idBars = dashboard.add(&bars, drawDashBars, NULL, 3);
+    int8_t idLines = dashboard.add(&lines, drawDashLines, NULL, 2);
+    dashboard.add(&pie, drawDashPie, NULL, 1);
+    dashboard.add(&slow, NULL, NULL, 0, 50000);
+
+    uint32_t maxBytes = 0;
+    uint32_t maxDrawn = 0;
+    raster.resetCounters();
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        dashBars[frame % N] = (y[frame % N] + frame / N) % 9;
+        dashSlow[frame % N] = (frame * 7) % 9;
+        dashboard.invalidate(idBars);
+        dashboard.invalidate(idLines);
+        slow.setDataBARS(dashSlow, N, 0, 8);
+
+        uint32_t bytes = raster.getCounters().bytes;
+        uint8_t drawn = dashboard.update(frame * DASH_TICK);
+        bytes = raster.getCounters().bytes - bytes;
+        maxBytes = (bytes > maxBytes) ? bytes : maxBytes;
+        maxDrawn = (drawn > maxDrawn) ? drawn : maxDrawn;
+    }
+
+    printf("dashboard %u frames, budget %u bytes: max %u bytes %u charts per frame, %u bytes/frame\n", frames,
+           DASH_BUDGET, maxBytes, maxDrawn, raster.getCounters().bytes / frames);
+    for (uint8_t i = 0; i < dashboard.getCount(); i++)
+    {
+        const GRAPH_CHART_STATS &c = dashboard.getStats(i);
+        printf("    %-8s %6u draws %6u coalesced %6u deferred %6u bytes last\n", names[i], c.draws, c.coalesced,
+               c.deferred, c.bytes);
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/dashboard.ppm", dir);
+    if (!raster.writePPM(path))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+    }
+}
+
+/* Burst: several changes per loop iteration */
+#define BURST_FPS 50
+#define BURST_TICK 1000 // Time between loop iterations in microseconds
+
+/**
+ * Apply a title, a colour and three data sets per iteration for `frames` iterations, in immediate
+ * mode then in retained mode capped at BURST_FPS.
+ */
+static void benchBurst(uint32_t frames, const char *dir)
+{
+    static char titles[2][8] = {"Burst", "Bursts"};
+    static const uint16_t colors[2] = {COLOR_SAND, COLOR_WHITE};
+
+    for (int retained = 0; retained < 2; retained++)
+    {
+        Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+        raster.clear(COLOR_BLACK);
+        Graph_TFT canva(&raster, CANVA_X, CANVA_Y, CANVA_W, CANVA_H, 15, 5, OCEAN);
+        canva.setFramebuffer(framebuffer);
+        canva.setRetained(retained);
+        canva.setFrameRate(BURST_FPS);
+
+        uint32_t drawn = 0;
+        raster.resetCounters();
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            uint16_t walk[N];
+            canva.setTitle(titles[(f / 100) % 2]);
+            canva.setDrawingSecondaryColour(colors[(f / 100) % 2]);
+            for (int k = 0; k < 3; k++)
+            {
+                for (int i = 0; i < N; i++)
+                    walk[i] = (y[i] + f + k) % 9;
+                canva.setDataBARS(walk, N, 0, 8);
+            }
+            drawn += canva.update(f * BURST_TICK);
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        const GRAPH_COUNTERS &c = raster.getCounters();
+        printf("burst    %-8s %8.2f us/iteration %4u frames %9u bytes\n", retained ? "retained" : "direct", elapsed / frames,
+               retained ? drawn : frames * 4, c.bytes);
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/burst_%s.ppm", dir, retained ? "retained" : "direct");
+        if (!raster.writePPM(path))
+        {
+            fprintf(stderr, "cannot write %s\n", path);
+        }
+    }
+}
+
+/* Display lists: the drawing order is part of a frame */
+static GRAPH_COMMAND orderCommands[2][4];
+static uint8_t orderScratch[256];
+
+/**
+ * Record two overlapping fills, then the same fills in the other order, and check that the diff
+ * covers their overlap.
+ */
+static void checkListOrder(void)
+{
+    Graph_List before(orderCommands[0], 4);
+    Graph_List after(orderCommands[1], 4);
+    before.fillRect(10, 10, 40, 30, COLOR_SAND);
+    before.fillRect(30, 20, 40, 30, COLOR_WHITE);
+    after.fillRect(30, 20, 40, 30, COLOR_WHITE);
+    after.fillRect(10, 10, 40, 30, COLOR_SAND);
+
+    Graph_Arena arena(orderScratch, sizeof(orderScratch));
+    GRAPH_RECT rects[GRAPH_LIST_RECTS];
+    uint8_t same = before.diff(before, rects, GRAPH_LIST_RECTS, arena);
+    uint8_t n = after.diff(before, rects, GRAPH_LIST_RECTS, arena);
+    bool covered = false;
+    for (uint8_t i = 0; i < n; i++)
+        covered |= rects[i].left <= 30 && rects[i].top <= 20 && rects[i].right >= 49 && rects[i].bottom >= 39;
+    bool redrawn = same == 0 && covered;
+    failed |= !redrawn;
+    printf("list     swapped overlapping fills: %u rects, %s\n", n, redrawn ? "overlap redrawn" : "STALE OVERLAP");
+}
+
+/* Fixed: bars and lines scaled with compile-time constants against the runtime ones */
+typedef Graph_TFT_Fixed<CANVA_W, CANVA_H, 15, OCEAN> Graph_Fixed;
+#define DENSE_POINTS 4096
+static uint16_t fixedScreen[SCREEN_WIDTH * SCREEN_HEIGHT];
+static uint16_t denseX[DENSE_POINTS], denseY[DENSE_POINTS];
+
+/* Charts written once for both types, so that the fixed one goes through its own setters */
+template <class C>
+static void fixedBarsWalk(C &canva, uint32_t frame)
+{
+    uint16_t walk[N];
+    for (int i = 0; i < N; i++)
+        walk[i] = y[i];
+    walk[frame % N] = (y[frame % N] + (frame / N) % 2) % 9;
+    canva.setDataBARS(walk, N, 0, 8);
+}
+
+template <class C>
+static void fixedGrouped(C &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataBARS(series, 3, N);
+}
+
+template <class C>
+static void fixedLines(C &canva, uint32_t frame)
+{
+    (void)frame;
+    canva.setDataLINES(x, y, N);
+}
+
+template <class C>
+static void fixedDense(C &canva, uint32_t frame)
+{
+    // Every sample is scaled by LTTB, the window slides by one sample per frame
+    uint32_t start = frame % (DENSE_POINTS / 2);
+    canva.setDecimation(LTTB);
+    canva.setDataLINES(denseX + start, denseY + start, DENSE_POINTS / 2, 0, 1023);
+}
+
+template <class C>
+static double timeFrames(C &canva, void (*render)(C &, uint32_t), uint32_t frames)
+{
+    canva.setFramebuffer(framebuffer);
+    canva.setScratch(scratch, sizeof(scratch));
+    canva.setTitle(title);
+    canva.setAxisDiv(1, 1);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        render(canva, f);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / frames;
+}
+
+/**
+ * Render each chart `frames` times with a runtime Graph_TFT then a Graph_TFT_Fixed of the same
+ * layout and style, and compare the time and the pixels.
+ */
+static void benchFixed(uint32_t frames)
+{
+    static const char *names[] = {"barswalk", "multig", "lines", "dense"};
+    static void (*const renders[])(Graph_TFT &, uint32_t) = {fixedBarsWalk<Graph_TFT>, fixedGrouped<Graph_TFT>, fixedLines<Graph_TFT>,
+                                                             fixedDense<Graph_TFT>};
+    static void (*const fixedRenders[])(Graph_Fixed &, uint32_t) = {fixedBarsWalk<Graph_Fixed>, fixedGrouped<Graph_Fixed>,
+                                                                    fixedLines<Graph_Fixed>, fixedDense<Graph_Fixed>};
+
+    for (uint32_t i = 0; i < DENSE_POINTS; i++)
+    {
+        denseX[i] = i;
+        denseY[i] = 512 + (int32_t)(400 * sin(i * 0.05)) + (int32_t)((i * 37) % 97) - 48;
+    }
+
+    for (size_t i = 0; i < sizeof(renders) / sizeof(renders[0]); i++)
+    {
+        Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+        raster.clear(COLOR_BLACK);
+        Graph_TFT canva(&raster, CANVA_X, CANVA_Y, CANVA_W, CANVA_H, 15, 5, OCEAN);
+        double runtime = timeFrames(canva, renders[i], frames);
+
+        Graph_Raster fixedRaster(fixedScreen, SCREEN_WIDTH, SCREEN_HEIGHT);
+        fixedRaster.clear(COLOR_BLACK);
+        Graph_Fixed fixed(&fixedRaster, CANVA_X, CANVA_Y);
+        double constant = timeFrames(fixed, fixedRenders[i], frames);
+
+        bool same = memcmp(screen, fixedScreen, sizeof(screen)) == 0;
+        failed |= !same;
+        printf("fixed    %-8s %8.2f us/frame runtime %8.2f us/frame fixed, %s\n", names[i], runtime, constant,
+               same ? "same pixels" : "DIFFERENT PIXELS");
+    }
+}
+
+/* Queue: producer thread against the render */
+#define QUEUE_ITEMS 10000000
+#define QUEUE_CAPACITY 1000 // Not a power of 2 on purpose
+
+static uint32_t queueStorage[QUEUE_CAPACITY];
+static uint16_t sampleStorage[QUEUE_CAPACITY];
+static uint16_t queueHistory[256];
+
+static void produceSequence(Graph_Queue<uint32_t> *queue)
+{
+    for (uint32_t i = 0; i < QUEUE_ITEMS; i++)
+    {
+        while (!queue->push(i))
+            std::this_thread::yield();
+    }
+}
+
+static void produceSamples(Graph_Queue<uint16_t> *queue, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        while (!queue->push(4 + ((i * 7) % 9) / 2 - (i / 16) % 3))
+            std::this_thread::yield();
+        // A few samples per period, like a sampling task
+        if (i % 4 == 3)
+            std::this_thread::yield();
+    }
+}
+
+/**
+ * Check that a sequence goes through the queue in order without loss, then render a stream fed by
+ * another thread for `frames` frames.
+ */
+static void benchQueue(uint32_t frames, const char *dir)
+{
+    Graph_Queue<uint32_t> sequence(queueStorage, QUEUE_CAPACITY);
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    uint32_t batch[64];
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::thread producer(produceSequence, &sequence);
+    while (expected < QUEUE_ITEMS)
+    {
+        // Alternate single and bulk pops
+        uint32_t n = (expected & 1) ? sequence.pop(batch, 64) : sequence.pop(batch[0]);
+        if (n == 0)
+        {
+            std::this_thread::yield();
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            errors += (batch[i] != expected++);
+        }
+    }
+    producer.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    failed |= errors > 0;
+    printf("queue    %u items %6.2f M/s, %u out of order, %u full pushes\n", QUEUE_ITEMS, QUEUE_ITEMS / elapsed / 1e6,
+           errors, sequence.getFailed());
+
+    Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+    raster.clear(COLOR_BLACK);
+    Graph_TFT canva(&raster, CANVA_X, CANVA_Y, CANVA_W, CANVA_H, 15, 5, OCEAN);
+    canva.setFramebuffer(framebuffer);
+    canva.setTitle(title);
+    canva.setAxisDiv(1, 1);
+    canva.setStream(queueHistory, 256, 0, 8);
+
+    Graph_Queue<uint16_t> samples(sampleStorage, QUEUE_CAPACITY);
+    uint32_t count = frames * 4;
+    uint32_t drained = 0;
+    uint32_t drawn = 0;
+    raster.resetCounters();
+    producer = std::thread(produceSamples, &samples, count);
+    while (drained < count)
+    {
+        uint32_t n = canva.drainSamples(samples);
+        drained += n;
+        drawn += (n > 0);
+        std::this_thread::yield();
+    }
+    producer.join();
+    printf("stream   %u samples in %u frames, %u bytes/frame, %u full pushes\n", drained, drawn,
+           raster.getCounters().bytes / (drawn ? drawn : 1), samples.getFailed());
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/queue.ppm", dir);
+    if (!raster.writePPM(path))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+    }
+}
+
+/* Ingest: framed binary samples through a pipe or a pseudo-terminal */
+#define INGEST_CHANNELS 3
+#define INGEST_POINTS 64 // Samples per channel of a sweep, sent in two frames
+#define INGEST_SPLIT 32  // Samples per channel of a frame
+#define INGEST_CORRUPT 23 // One frame in INGEST_CORRUPT has a byte flipped
+#define INGEST_MISSING 37 // One frame in INGEST_MISSING is never sent
+
+static uint8_t capture[GRAPH_INGEST_BYTES(INGEST_CHANNELS, INGEST_SPLIT) * 2 * 1000 + 16 * 1000];
+static uint8_t ingestBuffer[512];
+static uint16_t ingestSeries[INGEST_CHANNELS][INGEST_POINTS];
+static uint16_t ingestExpected[INGEST_CHANNELS][INGEST_POINTS];
+static uint16_t ingestX[INGEST_POINTS];
+
+/**
+ * Record `sweeps` sweeps of INGEST_CHANNELS channels as a capture, with faults.
+ * @return Size of the capture, the expected counts of dropped and rejected frames.
+ */
+static uint32_t recordCapture(uint32_t sweeps, uint32_t &dropped, uint32_t &rejected)
+{
+    uint32_t size = 0;
+    uint8_t seq = 0;
+    dropped = 0;
+    rejected = 0;
+    for (uint32_t s = 0; s < sweeps; s++)
+    {
+        for (int c = 0; c < INGEST_CHANNELS; c++)
+        {
+            for (int k = 0; k < INGEST_POINTS; k++)
+                ingestExpected[c][k] = 512 + (uint16_t)(400 * sin((k + s * (c + 1)) * 0.1 + c * 2.1) / (c + 1));
+        }
+        for (int part = 0; part < INGEST_POINTS / INGEST_SPLIT; part++)
+        {
+            const uint16_t *data[INGEST_CHANNELS];
+            for (int c = 0; c < INGEST_CHANNELS; c++)
+                data[c] = ingestExpected[c] + part * INGEST_SPLIT;
+            uint32_t n = Graph_Ingest::encode(capture + size, sizeof(capture) - size, data, INGEST_CHANNELS, INGEST_SPLIT,
+                                              part * INGEST_SPLIT, seq++);
+            // The last sweep arrives intact, so that the series can be checked
+            uint32_t frame = s * 2 + part;
+            bool last = (s + 1 == sweeps);
+            if (!last && frame % INGEST_MISSING == INGEST_MISSING - 1)
+            {
+                dropped++;
+                continue;
+            }
+            if (!last && frame % INGEST_CORRUPT == INGEST_CORRUPT - 1)
+            {
+                capture[size + 9 + frame % (n - 9)] ^= 0x10;
+                dropped++;
+                rejected++;
+            }
+            size += n;
+            if (!last && frame % 17 == 5)
+            {
+                // Line noise between two frames, including a false sync
+                static const uint8_t noise[] = {0x00, GRAPH_INGEST_SYNC0, 0x13, GRAPH_INGEST_SYNC0, GRAPH_INGEST_SYNC1, 0xff, 0xff};
+                memcpy(capture + size, noise, sizeof(noise));
+                size += sizeof(noise);
+                rejected++;
+            }
+        }
+    }
+    return size;
+}
+
+static void writeCapture(int fd, uint32_t size)
+{
+    // Uneven chunks, the way a UART driver hands them over
+    for (uint32_t sent = 0, chunk = 1; sent < size; chunk = chunk * 7 % 97 + 1)
+    {
+        uint32_t n = (chunk < size - sent) ? chunk : size - sent;
+        ssize_t w = write(fd, capture + sent, n);
+        if (w <= 0)
+            break;
+        sent += w;
+    }
+    close(fd);
+}
+
+static uint64_t nowMicros(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Decode a capture into a three series chart, from a pipe fed by a recorded capture or from a source.
+ */
+static void benchIngest(uint32_t frames, const char *dir, const char *source)
+{
+    uint32_t dropped = 0, rejected = 0, size = 0;
+    int fd = -1;
+    std::thread writer;
+    if (source != NULL)
+    {
+        fd = open(source, O_RDONLY | O_NOCTTY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "cannot open %s\n", source);
+            return;
+        }
+        struct termios tty;
+        if (tcgetattr(fd, &tty) == 0)
+        {
+            // Pseudo-terminal or serial port: raw bytes, no line discipline
+            cfmakeraw(&tty);
+            tcsetattr(fd, TCSANOW, &tty);
+        }
+    }
+    else
+    {
+        uint32_t sweeps = (frames < 1000) ? frames : 1000;
+        size = recordCapture(sweeps, dropped, rejected);
+        char path[256];
+        snprintf(path, sizeof(path), "%s/ingest.bin", dir);
+        FILE *file = fopen(path, "wb");
+        if (file == NULL || fwrite(capture, 1, size, file) != size)
+            fprintf(stderr, "cannot write %s\n", path);
+        if (file != NULL)
+            fclose(file);
+
+        int pipes[2];
+        if (pipe(pipes) != 0)
+            return;
+        fd = pipes[0];
+        writer = std::thread(writeCapture, pipes[1], size);
+    }
+
+    for (int k = 0; k < INGEST_POINTS; k++)
+        ingestX[k] = k;
+    uint16_t *series[INGEST_CHANNELS] = {ingestSeries[0], ingestSeries[1], ingestSeries[2]};
+    Graph_Ingest link(ingestBuffer, sizeof(ingestBuffer));
+    link.bind(series, INGEST_CHANNELS, INGEST_POINTS);
+
+    Graph_Raster raster(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+    raster.clear(COLOR_BLACK);
+    Graph_TFT canva(&raster, CANVA_X, CANVA_Y, CANVA_W, CANVA_H, 15, 5, OCEAN);
+    canva.setFramebuffer(framebuffer);
+    canva.setTitle(title);
+    canva.setAxisDiv(1, 1);
+    canva.setRetained(true);
+
+    uint32_t drawn = 0;
+    uint64_t t0 = nowMicros();
+    link.measure((uint32_t)t0);
+    for (;;)
+    {
+        uint32_t room;
+        uint8_t *p = link.receiveBuffer(room);
+        ssize_t n = read(fd, p, room);
+        if (n <= 0)
+            break;
+        link.received(n);
+        if (link.decode() > 0)
+        {
+            canva.setDataLINES(ingestX, (const uint16_t *const *)series, INGEST_CHANNELS, INGEST_POINTS, 0, 1023);
+            drawn += canva.render();
+        }
+    }
+    uint64_t t1 = nowMicros();
+    link.measure((uint32_t)t1);
+    close(fd);
+    if (writer.joinable())
+        writer.join();
+
+    const GRAPH_INGEST_COUNTERS &c = link.getCounters();
+    printf("ingest   %u bytes %u frames %u samples, %u dropped %u rejected %u skipped, %.2f MB/s %u frames/s, %u renders\n",
+           c.bytes, c.frames, c.samples, c.dropped, c.rejected, c.skipped, link.getByteRate() / 1e6, link.getFrameRate(), drawn);
+    if (source == NULL)
+    {
+        bool same = memcmp(ingestSeries, ingestExpected, sizeof(ingestSeries)) == 0;
+        bool match = c.bytes == size && c.dropped == dropped && c.rejected == rejected && same;
+        failed |= !match;
+        printf("ingest   expected %u bytes %u dropped %u rejected, %s\n", size, dropped, rejected, match ? "match" : "MISMATCH");
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/ingest.ppm", dir);
+    if (!raster.writePPM(path))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = (argc > 1) ? argv[1] : ".";
+    uint32_t frames = (argc > 2) ? atoi(argv[2]) : 100;
+    if (frames == 0)
+        frames = 1;
+    if (argc > 3)
+        bandwidth = strtoul(argv[3], NULL, 10);
+
+    for (int i = 0; i < N; i++)
+    {
+        x[i] = i + 3;
+        y[i] = 1 + (i * 3) % 8;
+        shuffled[i] = (i * 2) % N + 3;
+        y2[i] = 2 + (i * 5) % 7;
+        y3[i] = 8 - i;
+    }
+    makeCloud();
+
+    printf("framebuffer RGB565 %u bytes, 8 bpp %u bytes, 4 bpp %u bytes, strips %u bytes\n", (unsigned)sizeof(framebuffer),
+           (unsigned)GRAPH_INDEXED_BYTES(CANVA_W, CANVA_H, 8), (unsigned)GRAPH_INDEXED_BYTES(CANVA_W, CANVA_H, 4),
+           (unsigned)sizeof(stripBuffer));
+    for (int mode = 0; mode < MODES; mode++)
+    {
+        bench("bars", mode, renderBars, frames, dir);
+        bench("barswalk", mode, renderBarsWalk, frames, dir);
+        bench("barsx", mode, renderBarsExact, frames, dir);
+        bench("barsn", mode, renderBarsNice, frames, dir);
+        bench("lines", mode, renderLines, frames, dir);
+        bench("linesu", mode, renderLinesUnsorted, frames, dir);
+        bench("stream", mode, renderStream, frames, dir);
+        bench("streama", mode, renderStreamAuto, frames, dir);
+        bench("streamn", mode, renderStreamNice, frames, dir);
+        bench("multil", mode, renderMultiLines, frames, dir);
+        bench("multilu", mode, renderMultiLinesUnsorted, frames, dir);
+        bench("multig", mode, renderMultiGrouped, frames, dir);
+        bench("multis", mode, renderMultiStacked, frames, dir);
+        bench("specbars", mode, renderSpectrumBars, frames, dir);
+        bench("heat", mode, renderHeatmap, frames, dir);
+        bench("scatterr", mode, renderScatterRaw, frames, dir);
+        bench("scatter", mode, renderScatter, frames, dir);
+        bench("scatterd", mode, renderScatterDensity, frames, dir);
+        bench("pie", mode, renderPie, frames, dir);
+    }
+    benchDashboard(frames, dir);
+    benchQueue(frames, dir);
+    benchBurst(frames, dir);
+    benchFixed(frames);
+    checkListOrder();
+    benchIngest(frames, dir, (argc > 4) ? argv[4] : NULL);
+
+    return failed ? 1 : 0;
+}
@@ -12,7 +12,7 @@ uint16_t x[N];
 uint16_t y[N];
 uint8_t percentage[5] = {10,15,25,35,15};
 
-Graph_TFT canva = Graph_TFT(&tft, 4, 4, 124, 100, 15, 5, OCEAN);
+Graph_TFT canva(&tft, 4, 4, 124, 100, 15, 5, OCEAN);
 
 void setup() 
 {
@@ -35,6 +35,8 @@ void setup()
   //uint8_t percentage[5] = {12,28,10,10,40};
   //const char* labels[5] = {"Aa", "Bb", "Cc", "Dd", "Ee"};
   //canva.setDataPIE(percentage, 5, labels);
+  //static uint16_t history[256];
+  //canva.setStream(history, 256, 0, 8);
 }
 
 void loop() 
@@ -46,5 +48,6 @@ void loop()
   canva.setDataBARS( y, N);
   //canva.setDataLINES(x, y, N);
   //canva.setDataPIE(percentage, 5);
+  //canva.appendSample(1 + rand() % 8);
   delay(1000);
 }
\ No newline at end of file